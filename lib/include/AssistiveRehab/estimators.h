@@ -0,0 +1,115 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * \defgroup estimators estimators
+ *
+ * Classes for estimating derivatives of sampled signals.
+ *
+ * \section intro_sec Description
+ *
+ * The class DerivativeEstimator fits a polynomial of fixed order
+ * over a fixed window of the latest samples by means of least squares,
+ * in the spirit of Savitzky-Golay filters, yet handling non-uniform
+ * sampling times. Velocity, acceleration and jerk are then given by the
+ * derivatives of the polynomial at the latest sample.
+ * The work per sample is constant and no memory is allocated after
+ * construction.
+ *
+ * \section code_example_sec Example
+ *
+ * \code
+ * DerivativeEstimator est(3,16,3);
+ * est.estimate(x,Time::now());
+ * double speed=norm(est.getVelocity());
+ * double jerk=norm(est.getJerk());
+ * \endcode
+ *
+ * \author Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#ifndef ASSISTIVE_REHAB_ESTIMATORS_H
+#define ASSISTIVE_REHAB_ESTIMATORS_H
+
+#include <vector>
+#include <yarp/sig/Vector.h>
+
+namespace assistive_rehab
+{
+
+/**
+* \ingroup estimators
+*
+* Least-squares polynomial estimator of derivatives over a fixed window.
+*/
+class DerivativeEstimator
+{
+public:
+    static const unsigned int max_order=3;  /**< maximum order of the polynomial */
+
+protected:
+    unsigned int dim;
+    unsigned int window;
+    unsigned int order;
+    std::vector<double> times;
+    std::vector<double> samples;
+    unsigned int head;
+    unsigned int size;
+    yarp::sig::Vector derivatives[max_order+1];
+
+public:
+    /**
+    * Constructor.
+    * @param dim_ dimension of the samples.
+    * @param window_ number of samples the polynomial is fitted on.
+    * @param order_ order of the polynomial, up to max_order.
+    */
+    DerivativeEstimator(const unsigned int dim_, const unsigned int window_=8,
+                        const unsigned int order_=2);
+
+    /**
+    * Clear the window.
+    */
+    void reset();
+
+    /**
+    * Add a new sample and update the estimates.
+    * @param x the sample.
+    * @param t the time of the sample.
+    * @return true if enough samples have been collected for the
+    *         requested order, false if a lower order has been used.
+    */
+    bool estimate(const yarp::sig::Vector &x, const double t);
+
+    /**
+    * Retrieve the fitted value at the latest sample.
+    * @return the filtered sample.
+    */
+    const yarp::sig::Vector& getPosition() const { return derivatives[0]; }
+
+    /**
+    * Retrieve the first derivative at the latest sample.
+    * @return the velocity.
+    */
+    const yarp::sig::Vector& getVelocity() const { return derivatives[1]; }
+
+    /**
+    * Retrieve the second derivative at the latest sample.
+    * @return the acceleration, zero if order<2.
+    */
+    const yarp::sig::Vector& getAcceleration() const { return derivatives[2]; }
+
+    /**
+    * Retrieve the third derivative at the latest sample.
+    * @return the jerk, zero if order<3.
+    */
+    const yarp::sig::Vector& getJerk() const { return derivatives[3]; }
+};
+
+}
+
+#endif
@@ -0,0 +1,230 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * \defgroup opcClient opcClient
+ *
+ * Client of the objectsPropertiesCollector (OPC) keeping a local replica
+ * of its items.
+ *
+ * \section intro_sec Description
+ *
+ * The class OpcClient keeps a replica of the OPC items, indexed by their
+ * tag, which is read by any number of threads without contacting the OPC.
+ * The replica is fed in either of two ways:
+ * - broadcast: the port <name>:i is connected to /opc/broadcast:o; each
+ *   broadcast, either sync (periodic) or async (upon changes), carries
+ *   the whole database and replaces the replica. No rpc is ever issued.
+ * - rpc: the port <name> is connected to the OPC rpc port and refresh()
+ *   retrieves the items containing a given property through ask/get
+ *   requests, as the modules used to do on their own.
+ *
+ * Items are stored as received, hence skeletons are updated straight
+ * from them, without building intermediate Property objects. Callbacks
+ * are notified with the tags of the items that have been added, modified
+ * or removed with respect to the replica; items received unchanged are
+ * not notified.
+ *
+ * \section code_example_sec Example
+ *
+ * \code
+ * OpcClient opc;
+ * if (!opc.open("/module/opc",rf.check("opc-mode",Value("rpc")).asString()))
+ *     return false;
+ * ...
+ * opc.refresh();
+ * SkeletonStd skeleton;
+ * if (opc.getSkeleton(tag,skeleton))
+ *     skeleton.normalize();
+ * \endcode
+ *
+ * \author Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#ifndef ASSISTIVE_REHAB_OPCCLIENT_H
+#define ASSISTIVE_REHAB_OPCCLIENT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/RpcClient.h>
+#include "AssistiveRehab/skeleton.h"
+
+namespace assistive_rehab
+{
+
+/**
+* \ingroup opcClient
+*
+* Class for reading the OPC items from a local replica.
+*/
+class OpcClient
+{
+public:
+    /**
+    * Function called with the tags of the items that have been added,
+    * modified or removed.
+    */
+    typedef std::function<void(const std::vector<std::string>&)> Callback;
+
+protected:
+    /**
+    * Port receiving the broadcast.
+    */
+    class Reader : public yarp::os::BufferedPort<yarp::os::Bottle>
+    {
+        OpcClient *client;
+        void onRead(yarp::os::Bottle &msg) override { client->store(msg); }
+    public:
+        Reader(OpcClient *client_) : client(client_) { useCallback(); }
+    };
+
+    /**
+    * An item lives within the message it has been received with,
+    * which is shared by all the items of the same message and never
+    * modified once stored.
+    */
+    struct Item
+    {
+        std::shared_ptr<const yarp::os::Bottle> msg;
+        yarp::os::Bottle *item;
+    };
+
+    yarp::os::RpcClient rpcPort;
+    Reader broadcastPort;
+    bool broadcast;
+
+    mutable std::mutex mtx;
+    std::map<std::string,Item> items;
+
+    std::mutex mtx_callbacks;
+    std::vector<Callback> callbacks;
+
+    void store(const yarp::os::Bottle &msg);
+    bool find(const std::string &tag, Item &item) const;
+
+public:
+    /**
+    * Constructor.
+    */
+    OpcClient();
+
+    /**
+    * Destructor.
+    */
+    virtual ~OpcClient();
+
+    /**
+    * Open the ports.
+    * @param name the name of the rpc port; the broadcast port is named
+    *             after it with the suffix ":i".
+    * @param mode "broadcast" to feed the replica with the broadcast,
+    *             "rpc" to feed it through refresh().
+    * @return true/false on success/failure, including unknown modes.
+    */
+    bool open(const std::string &name, const std::string &mode);
+
+    /**
+    * Interrupt the ports.
+    */
+    void interrupt();
+
+    /**
+    * Close the ports.
+    */
+    void close();
+
+    /**
+    * Check whether the replica is fed with the broadcast.
+    * @return true if the broadcast is used.
+    */
+    bool isBroadcast() const { return broadcast; }
+
+    /**
+    * Check whether the port in use is connected to the OPC.
+    * @return true if connected.
+    */
+    bool isConnected();
+
+    /**
+    * Access the rpc port, e.g. to modify the OPC.
+    * @return the rpc port.
+    */
+    yarp::os::RpcClient& getRpcPort() { return rpcPort; }
+
+    /**
+    * Retrieve all the items containing a given property through rpc,
+    * replacing the replica. Nothing is done in broadcast mode, where
+    * the replica is always up to date.
+    * @param prop the property the items have to contain.
+    * @return true/false on success/failure.
+    */
+    bool refresh(const std::string &prop="skeleton");
+
+    /**
+    * Retrieve the tags of the items.
+    * @param prop if not empty, only items containing this property are considered.
+    * @return the tags.
+    */
+    std::vector<std::string> getTags(const std::string &prop="") const;
+
+    /**
+    * Retrieve the tags of the items whose property has a given value.
+    * @param prop the property to be checked.
+    * @param value the value of the property.
+    * @return the tags.
+    */
+    std::vector<std::string> select(const std::string &prop,
+                                    const yarp::os::Value &value) const;
+
+    /**
+    * Check whether an item is available.
+    * @param tag the tag of the item.
+    * @return true if available.
+    */
+    bool has(const std::string &tag) const;
+
+    /**
+    * Retrieve a copy of an item.
+    * @param tag the tag of the item.
+    * @param prop the Property filled with the item.
+    * @return true if the item is available.
+    */
+    bool get(const std::string &tag, yarp::os::Property &prop) const;
+
+    /**
+    * Update a skeleton straight from an item, leaving it untouched if
+    * the item is not available.
+    * @param tag the tag of the item.
+    * @param skeleton the skeleton to be updated.
+    * @return true if the item is available.
+    */
+    bool getSkeleton(const std::string &tag, Skeleton &skeleton) const;
+
+    /**
+    * Add a function to be called whenever the replica changes. In
+    * broadcast mode, it is called by the thread of the port, hence
+    * it should return quickly.
+    * @param callback the function.
+    */
+    void addCallback(const Callback &callback);
+
+    /**
+    * Empty the replica.
+    */
+    void clear();
+};
+
+}
+
+#endif
@@ -0,0 +1,201 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * \defgroup profiler profiler
+ *
+ * Classes for measuring the latency of processing stages.
+ *
+ * \section intro_sec Description
+ *
+ * The class Profiler collects the durations of a predefined set of stages
+ * into log-spaced histograms, from which counts and percentiles can be retrieved.
+ * Each thread records into its own histograms by means of relaxed atomic counters,
+ * hence recording never locks and never allocates after the first sample
+ * the thread provides.
+ * The class ScopedTimer measures the lifetime of a scope with a monotonic clock
+ * and records it into the profiler.
+ *
+ * \section code_example_sec Example
+ *
+ * \code
+ * Profiler profiler({"create","update"});
+ * {
+ *     ScopedTimer timer(profiler,0);
+ *     // stage "create"
+ * }
+ * StageStats stats=profiler.getStats(0);
+ * \endcode
+ *
+ * \author Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#ifndef ASSISTIVE_REHAB_PROFILER_H
+#define ASSISTIVE_REHAB_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+namespace assistive_rehab
+{
+
+/**
+* Latency statistics of a single stage.
+*/
+struct StageStats
+{
+    std::string name;   /**< stage's name */
+    uint64_t count;     /**< number of recorded samples */
+    double mean;        /**< mean duration (s) */
+    double p50;         /**< 50th percentile of the duration (s) */
+    double p95;         /**< 95th percentile of the duration (s) */
+    double p99;         /**< 99th percentile of the duration (s) */
+    double max;         /**< maximum duration (s) */
+};
+
+/**
+* \ingroup profiler
+*
+* Class for collecting per-stage latency histograms.
+*/
+class Profiler
+{
+public:
+    static const unsigned int bins_per_octave=4;   /**< histogram resolution */
+    static const unsigned int num_bins=40*bins_per_octave;  /**< bins cover up to 2^40 ns */
+
+protected:
+    /**
+    * Histograms written by a single thread.
+    */
+    struct Shard
+    {
+        std::unique_ptr<std::atomic<uint64_t>[]> bins;
+        std::unique_ptr<std::atomic<uint64_t>[]> sum;
+        std::unique_ptr<std::atomic<uint64_t>[]> max;
+        Shard(const size_t num_stages);
+    };
+
+    const uint64_t id;
+    std::vector<std::string> stages;
+    std::mutex mtx;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    Shard *getShard();
+    static unsigned int toBin(const uint64_t ns);
+    static double fromBin(const unsigned int bin);
+
+public:
+    /**
+    * Constructor.
+    * @param stages_ vector containing the names of the stages.
+    */
+    Profiler(const std::vector<std::string> &stages_);
+
+    /**
+    * Deleted copy constructor.
+    */
+    Profiler(const Profiler&) = delete;
+
+    /**
+    * Deleted copy operator.
+    */
+    Profiler& operator=(const Profiler&) = delete;
+
+    /**
+    * Virtual destructor.
+    */
+    virtual ~Profiler() { }
+
+    /**
+    * Retrieve the number of stages.
+    * @return number of stages.
+    */
+    size_t getNumStages() const { return stages.size(); }
+
+    /**
+    * Retrieve the name of a stage.
+    * @param stage index of the stage.
+    * @return reference to the name of the stage.
+    */
+    const std::string& getStageName(const size_t stage) const { return stages[stage]; }
+
+    /**
+    * Record the duration of a stage.
+    * @param stage index of the stage.
+    * @param ns duration expressed in nanoseconds.
+    */
+    void record(const size_t stage, const uint64_t ns);
+
+    /**
+    * Retrieve the statistics of a stage, aggregated over all threads.
+    * @param stage index of the stage.
+    * @return the statistics of the stage.
+    */
+    StageStats getStats(const size_t stage);
+
+    /**
+    * Retrieve the statistics of all stages.
+    * @return vector containing the statistics of each stage.
+    */
+    std::vector<StageStats> getStats();
+
+    /**
+    * Clear the collected samples.
+    */
+    void reset();
+};
+
+/**
+* \ingroup profiler
+*
+* Class for measuring the duration of a scope.
+*/
+class ScopedTimer
+{
+    Profiler *profiler;
+    size_t stage;
+    std::chrono::steady_clock::time_point t0;
+
+public:
+    /**
+    * Constructor. The timer starts upon construction.
+    * @param profiler_ the profiler where to record the duration.
+    * @param stage_ index of the stage.
+    */
+    ScopedTimer(Profiler &profiler_, const size_t stage_) :
+                profiler(&profiler_), stage(stage_),
+                t0(std::chrono::steady_clock::now()) { }
+
+    /**
+    * Deleted copy constructor.
+    */
+    ScopedTimer(const ScopedTimer&) = delete;
+
+    /**
+    * Deleted copy operator.
+    */
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    /**
+    * Destructor. The duration is recorded upon destruction.
+    */
+    ~ScopedTimer()
+    {
+        auto dt=std::chrono::steady_clock::now()-t0;
+        profiler->record(stage,(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count());
+    }
+};
+
+}
+
+#endif
@@ -89,6 +89,7 @@ extern const std::string SkeletonStd;
 
 class Skeleton;
 class SkeletonStd;
+class SkeletonStreamDecoder;
 
 /**
 * Basic class for single keypoint of a skeleton.
@@ -97,6 +98,7 @@ class KeyPoint
 {
     friend class Skeleton;
     friend class SkeletonStd;
+    friend class SkeletonStreamDecoder;
 
     bool updated;
     std::string tag;
@@ -219,6 +221,8 @@ public:
 */
 class Skeleton
 {
+    friend class SkeletonStreamDecoder;
+
 protected:
     std::string type; /**< skeleton's type ("assistive_rehab::SkeletonStd") */
     std::string tag; /**< skeleton's tag */
@@ -443,7 +447,8 @@ public:
 
     /**
     * Update skeleton from properties.
-    * @param prop a Property object containing skeleton information.
+    * @param prop a Property object containing skeleton information, or
+    *             directly the Bottle of an item as stored in the OPC.
     *
     * Available properties are:
     * - type: string containing skeleton's type ("assistive_rehab::SkeletonStd").
@@ -461,7 +466,7 @@ public:
     *       u,v.
     *     - child: list containing keypoint's child, specified as position, status, tag.
     */
-    virtual void update(const yarp::os::Property &prop);
+    virtual void update(const yarp::os::Searchable &prop);
 
     /**
     * Update skeleton planes.
@@ -0,0 +1,209 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * \defgroup skeletonStream skeletonStream
+ *
+ * Classes for streaming skeletons incrementally.
+ *
+ * \section intro_sec Description
+ *
+ * The class SkeletonStreamEncoder turns a sequence of skeletons into items
+ * to be appended to a stream: a skeleton is sent in full as a keyframe
+ * (i.e. the Property returned by Skeleton::toProperty()) the first time
+ * it is seen and then periodically, while in between only the keypoints
+ * that changed are sent as a delta item in compact binary form.
+ * The class SkeletonStreamDecoder applies a delta item to a skeleton
+ * previously built from a keyframe.
+ *
+ * Items of the same skeleton are numbered in sequence: keyframes carry
+ * the property seq, deltas carry the number after the tag. Since a delta
+ * is meaningful only if none of the previous ones got lost, receivers
+ * that may drop messages check items through SkeletonStreamDecoder::accept()
+ * and skip deltas after a gap until the next keyframe.
+ *
+ * A delta item is a list with the following properties:
+ * - delta: string containing skeleton's tag, followed by the sequence number.
+ * - keys: blob containing a record for each changed keypoint, made of
+ *   keypoint's index (uint8), status (uint8, 1 if updated) and
+ *   x,y,z,u,v coordinates (float32).
+ * - any extra property specified upon encoding (e.g. color, opacity).
+ *
+ * Transformation and planes are refreshed only by keyframes.
+ * Receivers unaware of the delta items can safely ignore them.
+ *
+ * \section code_example_sec Example
+ *
+ * \code
+ * SkeletonStreamEncoder encoder(30);
+ * Bottle &msg=port.prepare();
+ * msg.clear();
+ * encoder.encode(skeleton,msg);
+ * port.writeStrict();
+ * ...
+ * SkeletonStreamDecoder decoder;
+ * string tag;
+ * Bottle &item=*msg.get(0).asList();
+ * if (decoder.accept(item) && SkeletonStreamDecoder::isDelta(item,tag))
+ *     SkeletonStreamDecoder::decode(item,skeleton);
+ * \endcode
+ *
+ * \author Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#ifndef ASSISTIVE_REHAB_SKELETONSTREAM_H
+#define ASSISTIVE_REHAB_SKELETONSTREAM_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/sig/Matrix.h>
+#include "AssistiveRehab/skeleton.h"
+
+namespace assistive_rehab
+{
+
+/**
+* \ingroup skeletonStream
+*
+* Class for encoding skeletons as keyframes and deltas.
+*/
+class SkeletonStreamEncoder
+{
+protected:
+    /**
+    * Last state sent for a given skeleton.
+    */
+    struct State
+    {
+        std::vector<float> keys;
+        std::vector<unsigned char> status;
+        unsigned int cnt;
+        int seq;
+    };
+
+    unsigned int keyframe_period;
+    double threshold;
+    yarp::sig::Matrix T;
+    bool transform;
+    std::unordered_map<std::string,State> states;
+
+public:
+    /**
+    * Constructor.
+    * @param keyframe_period_ number of frames between two keyframes of the same
+    *                         skeleton; values lower than 2 disable deltas.
+    * @param threshold_ minimum displacement (m) for a keypoint to be sent again.
+    */
+    SkeletonStreamEncoder(const unsigned int keyframe_period_=30,
+                          const double threshold_=0.001);
+
+    /**
+    * Change the number of frames between two keyframes.
+    * @param keyframe_period_ number of frames; values lower than 2 disable deltas.
+    */
+    void setKeyFramePeriod(const unsigned int keyframe_period_) { keyframe_period=keyframe_period_; }
+
+    /**
+    * Change the minimum displacement for a keypoint to be sent again.
+    * @param threshold_ displacement (m).
+    */
+    void setThreshold(const double threshold_) { threshold=threshold_; }
+
+    /**
+    * Set a transformation to be applied to the skeletons being encoded,
+    * as Skeleton::setTransformation() followed by Skeleton::update() would
+    * do. Skeletons are copied only for keyframes, whereas deltas are
+    * computed from the transformed keypoints straightaway.
+    * @param T_ 4 x 4 homogeneous transformation matrix.
+    * @return true/false on success/failure.
+    */
+    bool setTransformation(const yarp::sig::Matrix &T_);
+
+    /**
+    * Append the item corresponding to the skeleton to a message.
+    * A delta item is always appended, even if no keypoint changed,
+    * so that receivers can keep track of the skeleton's liveness.
+    * @param skeleton the skeleton to be encoded.
+    * @param msg the message where to append the item.
+    * @param extra further properties to be attached to the item.
+    * @return true if a keyframe has been appended.
+    */
+    bool encode(Skeleton &skeleton, yarp::os::Bottle &msg,
+                const yarp::os::Property &extra=yarp::os::Property());
+
+    /**
+    * Forget the state of a skeleton, so that a keyframe will be sent next.
+    * @param tag string containing skeleton's tag.
+    */
+    void remove(const std::string &tag);
+
+    /**
+    * Forget the state of all skeletons not contained in a list.
+    * @param tags vector containing the tags of the skeletons to be retained.
+    */
+    void retain(const std::vector<std::string> &tags);
+
+    /**
+    * Forget the state of all skeletons.
+    */
+    void clear() { states.clear(); }
+};
+
+/**
+* \ingroup skeletonStream
+*
+* Class for decoding delta items.
+*/
+class SkeletonStreamDecoder
+{
+protected:
+    /**
+    * Sequence number of the last item applied to a given skeleton,
+    * negative if deltas are to be skipped until the next keyframe.
+    */
+    std::unordered_map<std::string,int> seqs;
+
+public:
+    /**
+    * Check the sequence number of an item, which is to be done for all
+    * the items received, in order. Keyframes are always accepted, while
+    * deltas are refused after a gap until the next keyframe. Items with
+    * no sequence number are always accepted.
+    * @param item the item to be checked.
+    * @return true if the item can be applied.
+    */
+    bool accept(const yarp::os::Bottle &item);
+
+    /**
+    * Forget the sequence of a skeleton.
+    * @param tag string containing skeleton's tag.
+    */
+    void remove(const std::string &tag) { seqs.erase(tag); }
+
+    /**
+    * Check whether an item is a delta.
+    * @param item the item to be checked.
+    * @param tag string filled with skeleton's tag.
+    * @return true if the item is a delta.
+    */
+    static bool isDelta(const yarp::os::Bottle &item, std::string &tag);
+
+    /**
+    * Apply a delta item to a skeleton, leaving unchanged keypoints untouched.
+    * @param item the delta item.
+    * @param skeleton the skeleton to be updated.
+    * @return true/false on success/failure.
+    */
+    static bool decode(const yarp::os::Bottle &item, Skeleton &skeleton);
+};
+
+}
+
+#endif
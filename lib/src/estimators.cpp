@@ -0,0 +1,160 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file estimators.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "AssistiveRehab/estimators.h"
+
+using namespace std;
+using namespace yarp::sig;
+using namespace assistive_rehab;
+
+const unsigned int DerivativeEstimator::max_order;
+
+namespace
+{
+
+const unsigned int N=DerivativeEstimator::max_order+1;
+
+/****************************************************************/
+bool cholesky(const double A[N][N], double L[N][N], const unsigned int n)
+{
+    for (unsigned int i=0; i<n; i++)
+    {
+        for (unsigned int j=0; j<=i; j++)
+        {
+            double sum=A[i][j];
+            for (unsigned int k=0; k<j; k++)
+                sum-=L[i][k]*L[j][k];
+
+            if (i==j)
+            {
+                if (sum<=1e-12)
+                    return false;
+                L[i][i]=sqrt(sum);
+            }
+            else
+                L[i][j]=sum/L[j][j];
+        }
+    }
+    return true;
+}
+
+/****************************************************************/
+void backsubstitute(const double L[N][N], double *b, const unsigned int n)
+{
+    for (unsigned int i=0; i<n; i++)
+    {
+        for (unsigned int k=0; k<i; k++)
+            b[i]-=L[i][k]*b[k];
+        b[i]/=L[i][i];
+    }
+    for (int i=n-1; i>=0; i--)
+    {
+        for (unsigned int k=i+1; k<n; k++)
+            b[i]-=L[k][i]*b[k];
+        b[i]/=L[i][i];
+    }
+}
+
+}
+
+/****************************************************************/
+DerivativeEstimator::DerivativeEstimator(const unsigned int dim_,
+                                         const unsigned int window_,
+                                         const unsigned int order_) :
+                     dim(dim_), window(std::max(window_,2U)),
+                     order(std::min(order_,max_order))
+{
+    times.assign(window,0.0);
+    samples.assign(window*dim,0.0);
+    for (auto &d:derivatives)
+        d.resize(dim,0.0);
+    reset();
+}
+
+/****************************************************************/
+void DerivativeEstimator::reset()
+{
+    head=size=0;
+    for (auto &d:derivatives)
+        d=0.0;
+}
+
+/****************************************************************/
+bool DerivativeEstimator::estimate(const Vector &x, const double t)
+{
+    times[head]=t;
+    copy(x.begin(),x.begin()+dim,samples.begin()+head*dim);
+    head=(head+1)%window;
+    size=std::min(size+1,window);
+
+    // normalize times within [-1,0] to keep the system well conditioned
+    unsigned int oldest=(head+window-size)%window;
+    double h=t-times[oldest];
+    if (h<=0.0)
+        h=1.0;
+
+    double A[N][N]={};
+    unsigned int n=std::min(order,size-1)+1;
+    for (unsigned int i=0; i<size; i++)
+    {
+        unsigned int idx=(oldest+i)%window;
+        double s=(times[idx]-t)/h;
+        double p[2*N-1];
+        p[0]=1.0;
+        for (unsigned int k=1; k<2*n-1; k++)
+            p[k]=p[k-1]*s;
+        for (unsigned int j=0; j<n; j++)
+            for (unsigned int k=0; k<n; k++)
+                A[j][k]+=p[j+k];
+    }
+
+    // drop the order until the fit is well posed (e.g. repeated times)
+    double L[N][N]={};
+    while ((n>1) && !cholesky(A,L,n))
+        n--;
+    if (n==1)
+        cholesky(A,L,n);
+
+    for (unsigned int d=0; d<dim; d++)
+    {
+        double c[N]={};
+        for (unsigned int i=0; i<size; i++)
+        {
+            unsigned int idx=(oldest+i)%window;
+            double s=(times[idx]-t)/h;
+            double x_i=samples[idx*dim+d];
+            double p=1.0;
+            for (unsigned int j=0; j<n; j++)
+            {
+                c[j]+=p*x_i;
+                p*=s;
+            }
+        }
+        backsubstitute(L,c,n);
+
+        // k-th derivative at s=0 is k!*c_k/h^k
+        double fact=1.0,hk=1.0;
+        for (unsigned int k=0; k<=max_order; k++)
+        {
+            if (k>0)
+            {
+                fact*=k;
+                hk*=h;
+            }
+            derivatives[k][d]=(k<n)?fact*c[k]/hk:0.0;
+        }
+    }
+
+    return (n==order+1);
+}
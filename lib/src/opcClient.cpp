@@ -0,0 +1,215 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file opcClient.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <yarp/os/Vocab.h>
+#include "AssistiveRehab/opcClient.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace assistive_rehab;
+
+OpcClient::OpcClient() : broadcastPort(this), broadcast(false)
+{
+}
+
+OpcClient::~OpcClient()
+{
+    close();
+}
+
+bool OpcClient::open(const string &name, const string &mode)
+{
+    if ((mode!="rpc") && (mode!="broadcast"))
+        return false;
+
+    broadcast=(mode=="broadcast");
+    bool ret=rpcPort.open(name);
+    if (broadcast)
+        ret=ret && broadcastPort.open(name+":i");
+    return ret;
+}
+
+void OpcClient::interrupt()
+{
+    rpcPort.interrupt();
+    broadcastPort.interrupt();
+}
+
+void OpcClient::close()
+{
+    if (rpcPort.asPort().isOpen())
+        rpcPort.close();
+    if (!broadcastPort.isClosed())
+        broadcastPort.close();
+}
+
+bool OpcClient::isConnected()
+{
+    if (broadcast)
+        return (broadcastPort.getInputCount()>0);
+    return (rpcPort.getOutputCount()>0);
+}
+
+void OpcClient::store(const Bottle &msg)
+{
+    string type=msg.get(0).asString();
+    if ((type!="sync") && (type!="async"))
+        return;
+
+    // items point into one copy of the message, made outside the lock
+    shared_ptr<const Bottle> copy=make_shared<const Bottle>(msg);
+    map<string,Item> received;
+    for (int i=1; i<copy->size(); i++)
+    {
+        if (Bottle *b=copy->get(i).asList())
+        {
+            string tag=b->find("tag").asString();
+            if (!tag.empty())
+                received[tag]=Item{copy,b};
+        }
+    }
+
+    // messages carry the whole database, hence items not received are gone
+    vector<string> changed;
+    {
+        lock_guard<mutex> lg(mtx);
+        for (auto &it:items)
+            if (received.find(it.first)==received.end())
+                changed.push_back(it.first);
+        for (auto &it:received)
+        {
+            auto prev=items.find(it.first);
+            if ((prev==items.end()) || (*prev->second.item!=*it.second.item))
+                changed.push_back(it.first);
+        }
+        items.swap(received);
+    }
+
+    lock_guard<mutex> lg(mtx_callbacks);
+    if (!changed.empty())
+        for (auto &callback:callbacks)
+            callback(changed);
+}
+
+bool OpcClient::find(const string &tag, Item &item) const
+{
+    lock_guard<mutex> lg(mtx);
+    auto it=items.find(tag);
+    if (it!=items.end())
+    {
+        item=it->second;
+        return true;
+    }
+    return false;
+}
+
+bool OpcClient::refresh(const string &prop)
+{
+    if (broadcast)
+        return true;
+
+    // ask for the ids of the items containing the property
+    Bottle cmd,reply;
+    cmd.addVocab(Vocab::encode("ask"));
+    Bottle &content=cmd.addList().addList();
+    content.addString(prop);
+    if (!rpcPort.write(cmd,reply))
+        return false;
+    if ((reply.size()<2) || (reply.get(0).asVocab()!=Vocab::encode("ack")))
+        return false;
+
+    Bottle *idField=reply.get(1).asList();
+    Bottle *idValues=(idField!=nullptr?idField->get(1).asList():nullptr);
+    if (idValues==nullptr)
+        return false;
+
+    // given the ids, get the items, which make up a sync message
+    Bottle msg;
+    msg.addString("sync");
+    for (int i=0; i<idValues->size(); i++)
+    {
+        cmd.clear();
+        cmd.addVocab(Vocab::encode("get"));
+        Bottle &content=cmd.addList().addList();
+        content.addString("id");
+        content.addInt(idValues->get(i).asInt());
+        Bottle replyProp;
+        if (rpcPort.write(cmd,replyProp))
+            if (replyProp.get(0).asVocab()==Vocab::encode("ack"))
+                if (Bottle *propField=replyProp.get(1).asList())
+                    msg.addList()=*propField;
+    }
+
+    store(msg);
+    return true;
+}
+
+vector<string> OpcClient::getTags(const string &prop) const
+{
+    lock_guard<mutex> lg(mtx);
+    vector<string> tags;
+    for (auto &it:items)
+        if (prop.empty() || it.second.item->check(prop))
+            tags.push_back(it.first);
+    return tags;
+}
+
+vector<string> OpcClient::select(const string &prop, const Value &value) const
+{
+    lock_guard<mutex> lg(mtx);
+    vector<string> tags;
+    for (auto &it:items)
+        if (it.second.item->find(prop)==value)
+            tags.push_back(it.first);
+    return tags;
+}
+
+bool OpcClient::has(const string &tag) const
+{
+    lock_guard<mutex> lg(mtx);
+    return (items.find(tag)!=items.end());
+}
+
+bool OpcClient::get(const string &tag, Property &prop) const
+{
+    Item item;
+    if (find(tag,item))
+    {
+        item.item->write(prop);
+        return true;
+    }
+    return false;
+}
+
+bool OpcClient::getSkeleton(const string &tag, Skeleton &skeleton) const
+{
+    // the message stays alive while held, even if replaced meanwhile
+    Item item;
+    if (find(tag,item))
+    {
+        skeleton.update(*item.item);
+        return true;
+    }
+    return false;
+}
+
+void OpcClient::addCallback(const Callback &callback)
+{
+    lock_guard<mutex> lg(mtx_callbacks);
+    callbacks.push_back(callback);
+}
+
+void OpcClient::clear()
+{
+    lock_guard<mutex> lg(mtx);
+    items.clear();
+}
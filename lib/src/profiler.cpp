@@ -0,0 +1,156 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file profiler.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include "AssistiveRehab/profiler.h"
+
+using namespace std;
+using namespace assistive_rehab;
+
+namespace
+{
+atomic<uint64_t> profiler_ids(0);
+}
+
+const unsigned int Profiler::bins_per_octave;
+const unsigned int Profiler::num_bins;
+
+Profiler::Shard::Shard(const size_t num_stages) :
+                       bins(new atomic<uint64_t>[num_stages*num_bins]),
+                       sum(new atomic<uint64_t>[num_stages]),
+                       max(new atomic<uint64_t>[num_stages])
+{
+    for (size_t i=0; i<num_stages*num_bins; i++)
+        bins[i].store(0,memory_order_relaxed);
+    for (size_t i=0; i<num_stages; i++)
+    {
+        sum[i].store(0,memory_order_relaxed);
+        max[i].store(0,memory_order_relaxed);
+    }
+}
+
+Profiler::Profiler(const vector<string> &stages_) :
+                   id(profiler_ids.fetch_add(1)), stages(stages_)
+{
+}
+
+Profiler::Shard *Profiler::getShard()
+{
+    // each thread caches its own shard, so that the lock
+    // is taken only the first time the thread records
+    thread_local unordered_map<uint64_t,Shard*> cache;
+    auto it=cache.find(id);
+    if (it!=cache.end())
+        return it->second;
+
+    lock_guard<mutex> lg(mtx);
+    shards.push_back(unique_ptr<Shard>(new Shard(stages.size())));
+    Shard *shard=shards.back().get();
+    cache[id]=shard;
+    return shard;
+}
+
+unsigned int Profiler::toBin(const uint64_t ns)
+{
+    if (ns<=1)
+        return 0;
+    unsigned int bin=(unsigned int)(bins_per_octave*log2((double)ns));
+    return std::min(bin,num_bins-1);
+}
+
+double Profiler::fromBin(const unsigned int bin)
+{
+    return 1e-9*pow(2.0,(bin+0.5)/bins_per_octave);
+}
+
+void Profiler::record(const size_t stage, const uint64_t ns)
+{
+    if (stage<stages.size())
+    {
+        // the shard is written by this thread only
+        Shard *shard=getShard();
+        shard->bins[stage*num_bins+toBin(ns)].fetch_add(1,memory_order_relaxed);
+        shard->sum[stage].fetch_add(ns,memory_order_relaxed);
+        if (ns>shard->max[stage].load(memory_order_relaxed))
+            shard->max[stage].store(ns,memory_order_relaxed);
+    }
+}
+
+StageStats Profiler::getStats(const size_t stage)
+{
+    StageStats stats;
+    stats.count=0;
+    stats.mean=stats.p50=stats.p95=stats.p99=stats.max=0.0;
+    if (stage>=stages.size())
+        return stats;
+
+    stats.name=stages[stage];
+    vector<uint64_t> hist(num_bins,0);
+    uint64_t sum=0,max=0;
+    {
+        lock_guard<mutex> lg(mtx);
+        for (auto &shard:shards)
+        {
+            for (unsigned int i=0; i<num_bins; i++)
+                hist[i]+=shard->bins[stage*num_bins+i].load(memory_order_relaxed);
+            sum+=shard->sum[stage].load(memory_order_relaxed);
+            max=std::max(max,shard->max[stage].load(memory_order_relaxed));
+        }
+    }
+
+    for (auto &h:hist)
+        stats.count+=h;
+
+    if (stats.count>0)
+    {
+        stats.mean=1e-9*sum/stats.count;
+        stats.max=1e-9*max;
+
+        const double q[3]={0.5,0.95,0.99};
+        double *p[3]={&stats.p50,&stats.p95,&stats.p99};
+        uint64_t cumulative=0;
+        unsigned int j=0;
+        for (unsigned int i=0; (i<num_bins) && (j<3); i++)
+        {
+            cumulative+=hist[i];
+            while ((j<3) && (cumulative>=q[j]*stats.count))
+                *p[j++]=std::min(fromBin(i),stats.max);
+        }
+    }
+
+    return stats;
+}
+
+vector<StageStats> Profiler::getStats()
+{
+    vector<StageStats> stats;
+    for (size_t i=0; i<stages.size(); i++)
+        stats.push_back(getStats(i));
+    return stats;
+}
+
+void Profiler::reset()
+{
+    lock_guard<mutex> lg(mtx);
+    for (auto &shard:shards)
+    {
+        for (size_t i=0; i<stages.size()*num_bins; i++)
+            shard->bins[i].store(0,memory_order_relaxed);
+        for (size_t i=0; i<stages.size(); i++)
+        {
+            shard->sum[i].store(0,memory_order_relaxed);
+            shard->max[i].store(0,memory_order_relaxed);
+        }
+    }
+}
@@ -556,7 +556,7 @@ void Skeleton::update_withpixels(const vector<pair<string,pair<Vector,Vector>>>
     update_planes();
 }
 
-void Skeleton::update(const Property &prop)
+void Skeleton::update(const Searchable &prop)
 {
     if (prop.check("type"))
         if (prop.find("type").asString()!=type)
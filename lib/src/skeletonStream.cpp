@@ -0,0 +1,250 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file skeletonStream.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include "AssistiveRehab/skeletonStream.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace assistive_rehab;
+
+namespace
+{
+// index, status, x, y, z, u, v
+const size_t record_size=2*sizeof(unsigned char)+5*sizeof(float);
+
+// sequence numbers wrap around staying positive
+int next(const int seq)
+{
+    return (seq+1)&0x7fffffff;
+}
+}
+
+SkeletonStreamEncoder::SkeletonStreamEncoder(const unsigned int keyframe_period_,
+                                             const double threshold_) :
+                                             keyframe_period(keyframe_period_),
+                                             threshold(threshold_),
+                                             transform(false)
+{
+}
+
+bool SkeletonStreamEncoder::setTransformation(const yarp::sig::Matrix &T_)
+{
+    if ((T_.rows()<4) || (T_.cols()<4))
+        return false;
+
+    T=T_.submatrix(0,3,0,3);
+    transform=true;
+    return true;
+}
+
+bool SkeletonStreamEncoder::encode(Skeleton &skeleton, Bottle &msg,
+                                   const Property &extra)
+{
+    const string &tag=skeleton.getTag();
+    const unsigned int n=std::min(skeleton.getNumKeyPoints(),256U);
+
+    Bottle extra_(extra.toString());
+
+    auto it=states.find(tag);
+    bool keyframe=(keyframe_period<2) || (it==states.end()) ||
+                  (it->second.status.size()!=n) || (it->second.cnt+1>=keyframe_period);
+
+    if (keyframe)
+    {
+        // the transformation is applied to a copy, which is sent in full
+        unique_ptr<Skeleton> transformed;
+        Skeleton *source=&skeleton;
+        if (transform)
+        {
+            transformed=unique_ptr<Skeleton>(skeleton_factory(skeleton.toProperty()));
+            if (transformed!=nullptr)
+            {
+                transformed->setTransformation(T);
+                transformed->update();
+                source=transformed.get();
+            }
+        }
+
+        int seq=(it!=states.end()?next(it->second.seq):0);
+        State &state=states[tag];
+        state.keys.resize(5*n);
+        state.status.resize(n);
+        state.cnt=0;
+        state.seq=seq;
+        for (unsigned int i=0; i<n; i++)
+        {
+            const KeyPoint *k=(*source)[i];
+            const auto &p=k->getPoint();
+            const auto &px=k->getPixel();
+            float *keys=&state.keys[5*i];
+            keys[0]=(float)p[0]; keys[1]=(float)p[1]; keys[2]=(float)p[2];
+            keys[3]=(float)px[0]; keys[4]=(float)px[1];
+            state.status[i]=(unsigned char)k->isUpdated();
+        }
+
+        Property prop=source->toProperty();
+        prop.put("seq",seq);
+        Bottle &item=msg.addList();
+        item.read(prop);
+        item.append(extra_);
+        return true;
+    }
+
+    State &state=it->second;
+    state.cnt++;
+    state.seq=next(state.seq);
+
+    vector<char> buf;
+    buf.reserve(n*record_size);
+    for (unsigned int i=0; i<n; i++)
+    {
+        const KeyPoint *k=skeleton[i];
+        const auto &p_=k->getPoint();
+        float *keys=&state.keys[5*i];
+        unsigned char status=(unsigned char)k->isUpdated();
+
+        // as Skeleton::update(), only updated keypoints get transformed
+        double p[3]={p_[0],p_[1],p_[2]};
+        if (transform && status)
+            for (int j=0; j<3; j++)
+                p[j]=T(j,0)*p_[0]+T(j,1)*p_[1]+T(j,2)*p_[2]+T(j,3);
+
+        // stale keypoints are sent only when their status changes
+        bool changed=(status!=state.status[i]);
+        if (!changed && status)
+        {
+            double d=0.0;
+            for (int j=0; j<3; j++)
+                d+=(p[j]-keys[j])*(p[j]-keys[j]);
+            changed=(sqrt(d)>threshold) || std::isnan(d);
+        }
+
+        if (changed)
+        {
+            const auto &px=k->getPixel();
+            keys[0]=(float)p[0]; keys[1]=(float)p[1]; keys[2]=(float)p[2];
+            keys[3]=(float)px[0]; keys[4]=(float)px[1];
+            state.status[i]=status;
+
+            unsigned char header[2]={(unsigned char)i,status};
+            buf.insert(buf.end(),header,header+2);
+            const char *data=reinterpret_cast<const char*>(keys);
+            buf.insert(buf.end(),data,data+5*sizeof(float));
+        }
+    }
+
+    Bottle &item=msg.addList();
+    Bottle &delta=item.addList();
+    delta.addString("delta");
+    delta.addString(tag);
+    delta.addInt(state.seq);
+    Bottle &payload=item.addList();
+    payload.addString("keys");
+    payload.add(Value::makeBlob(buf.data(),(int)buf.size()));
+    item.append(extra_);
+    return false;
+}
+
+void SkeletonStreamEncoder::remove(const string &tag)
+{
+    states.erase(tag);
+}
+
+void SkeletonStreamEncoder::retain(const vector<string> &tags)
+{
+    for (auto it=states.begin(); it!=states.end();)
+    {
+        if (find(tags.begin(),tags.end(),it->first)==tags.end())
+            it=states.erase(it);
+        else
+            it++;
+    }
+}
+
+bool SkeletonStreamDecoder::isDelta(const Bottle &item, string &tag)
+{
+    if (Bottle *delta=item.get(0).asList())
+    {
+        if ((delta->size()>=2) && (delta->get(0).asString()=="delta"))
+        {
+            tag=delta->get(1).asString();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SkeletonStreamDecoder::accept(const Bottle &item)
+{
+    string tag;
+    if (isDelta(item,tag))
+    {
+        Bottle *delta=item.get(0).asList();
+        if (delta->size()<3)
+            return true;
+
+        // deltas apply only in sequence, on top of a keyframe
+        auto it=seqs.find(tag);
+        int seq=delta->get(2).asInt();
+        if ((it!=seqs.end()) && (it->second>=0) && (seq==next(it->second)))
+        {
+            it->second=seq;
+            return true;
+        }
+        seqs[tag]=-1;
+        return false;
+    }
+
+    Value &seq=item.find("seq");
+    tag=item.find("tag").asString();
+    if (!tag.empty())
+    {
+        if (seq.isInt())
+            seqs[tag]=seq.asInt();
+        else
+            seqs.erase(tag);
+    }
+    return true;
+}
+
+bool SkeletonStreamDecoder::decode(const Bottle &item, Skeleton &skeleton)
+{
+    string tag;
+    if (!isDelta(item,tag) || (tag!=skeleton.getTag()))
+        return false;
+
+    Value &keys=item.find("keys");
+    if (!keys.isBlob())
+        return false;
+
+    const char *buf=keys.asBlob();
+    size_t len=keys.asBlobLength();
+    float data[5];
+    for (size_t offset=0; offset+record_size<=len; offset+=record_size)
+    {
+        unsigned int i=(unsigned char)buf[offset];
+        if (i>=skeleton.keypoints.size())
+            return false;
+
+        memcpy(data,buf+offset+2,sizeof(data));
+        KeyPoint *k=skeleton.keypoints[i];
+        k->updated=(buf[offset+1]!=0);
+        k->point[0]=data[0]; k->point[1]=data[1]; k->point[2]=data[2];
+        k->pixel[0]=data[3]; k->pixel[1]=data[4];
+    }
+
+    return true;
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file classifier.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __CLASSIFIER_H__
+#define __CLASSIFIER_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//network scoring windows of keypoints, whatever runs it
+class Classifier
+{
+public:
+    virtual ~Classifier() { }
+
+    //model files are found from the given path, without extension
+    virtual bool load(const std::string &model) = 0;
+
+    //n windows of nframes frames of nfeatures each, one after the other;
+    //scores are not normalized, n*nclasses of them
+    virtual bool classify(const float *windows, const int n, const int nframes,
+                          const int nfeatures, std::vector<float> &scores) = 0;
+
+    virtual std::string getError() const = 0;
+
+    //bytes taken by the loaded network, as far as can be told
+    virtual size_t getFootprint() const = 0;
+};
+
+//nullptr if the module is built without Tensorflow; 0 threads lets
+//Tensorflow decide
+Classifier *createTensorflowClassifier(const int intra_op_threads,
+                                       const int inter_op_threads);
+
+//as trained, in float or 8-bit integer precision
+Classifier *createNativeClassifier(const bool quantized);
+
+#endif
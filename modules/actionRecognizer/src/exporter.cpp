@@ -0,0 +1,124 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file exporter.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tensorflow/core/public/session.h>
+#include <tensorflow/core/protobuf/meta_graph.pb.h>
+#include "lstm.h"
+
+using namespace std;
+using namespace tensorflow;
+
+/********************************************************/
+//fetches a trained variable, checking its rank
+bool fetch(Session *session, const string &name, const int rank,
+           vector<float> &v, vector<int> &dims)
+{
+    vector<Tensor> out;
+    Status status=session->Run({},{name+":0"},{},&out);
+    if(!status.ok() || out[0].dims()!=rank)
+    {
+        cerr<<"Unable to fetch "<<name<<": "<<status.ToString()<<endl;
+        return false;
+    }
+
+    auto flat=out[0].flat<float>();
+    v.assign(flat.data(),flat.data()+flat.size());
+    dims.clear();
+    for(int i=0; i<rank; i++)
+    {
+        dims.push_back((int)out[0].dim_size(i));
+    }
+    return true;
+}
+
+/********************************************************/
+//usage: actionRecognizerExporter <model path without extension>
+//writes the weights of model.meta/model.data to model.bin
+int main(int argc, char *argv[])
+{
+    if(argc<2)
+    {
+        cerr<<"usage: "<<argv[0]<<" <model path without extension>"<<endl;
+        return EXIT_FAILURE;
+    }
+    string model=argv[1];
+
+    Session *session=NewSession(SessionOptions());
+    MetaGraphDef graph_def;
+    Status status=ReadBinaryProto(Env::Default(),model+".meta",&graph_def);
+    if(status.ok())
+    {
+        status=session->Create(graph_def.graph_def());
+    }
+    if(status.ok())
+    {
+        Tensor checkpointPathTensor(DT_STRING,TensorShape());
+        checkpointPathTensor.scalar<std::string>()()=model;
+        status=session->Run({{graph_def.saver_def().filename_tensor_name(),checkpointPathTensor},},
+                            {},{graph_def.saver_def().restore_op_name()},nullptr);
+    }
+    if(!status.ok())
+    {
+        cerr<<"Unable to restore "<<model<<": "<<status.ToString()<<endl;
+        return EXIT_FAILURE;
+    }
+
+    LstmWeights w;
+    vector<int> dims;
+    bool ok=fetch(session,"hidden_weights",2,w.wembed,dims);
+    w.nfeatures=ok?dims[0]:0;
+    w.nembed=ok?dims[1]:0;
+    ok=ok && fetch(session,"hidden_biases",1,w.bembed,dims);
+    ok=ok && fetch(session,"out_weights",2,w.wout,dims);
+    w.nhidden=ok?dims[0]:0;
+    w.nclasses=ok?dims[1]:0;
+    ok=ok && fetch(session,"out_biases",1,w.bout,dims);
+
+    //as many layers as found in the graph
+    for(int l=0; ok; l++)
+    {
+        string cell="rnn/multi_rnn_cell/cell_"+to_string(l)+"/basic_lstm_cell/";
+        vector<float> kernel,bias;
+        if(!fetch(session,cell+"kernel",2,kernel,dims))
+        {
+            break;
+        }
+        ok=fetch(session,cell+"bias",1,bias,dims);
+        w.kernels.push_back(kernel);
+        w.biases.push_back(bias);
+    }
+    ok=ok && !w.kernels.empty();
+
+    //BasicLSTMCell adds its forget bias as a constant
+    vector<float> forget_bias;
+    if(ok && fetch(session,"rnn/rnn/multi_rnn_cell/cell_0/basic_lstm_cell/Const_2",0,forget_bias,dims))
+    {
+        w.forget_bias=forget_bias[0];
+    }
+
+    session->Close();
+    delete session;
+
+    if(!ok || !w.save(model+".bin"))
+    {
+        cerr<<"Unable to export "<<model<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"Exported "<<w.kernels.size()<<" LSTM layers of "<<w.nhidden
+        <<" units to "<<model+".bin"<<endl;
+    return EXIT_SUCCESS;
+}
@@ -31,12 +31,34 @@ service actionRecognizer_IDL
    bool run(1:i32 nframes_);
 
    /**
-    * Start the interaction.
+    * Follow only the given skeleton.
     * @param tag of the current skeleton
     * @return true/false on success/failure.
     */
    bool tags(1:string skel_tag_);
 
+   /**
+    * Follow one more skeleton, along with those already followed.
+    * Windows of all skeletons are classified together, and the
+    * predictions are published along with the tag of the skeleton.
+    * @param tag of the skeleton to add
+    * @return true/false on success/failure.
+    */
+   bool addTag(1:string skel_tag_);
+
+   /**
+    * Stop following a skeleton.
+    * @param tag of the skeleton to remove
+    * @return true/false on success/failure.
+    */
+   bool removeTag(1:string skel_tag_);
+
+   /**
+    * Get the tags of the followed skeletons.
+    * @return the list of tags.
+    */
+   list<string> getTags();
+
    /**
     * Load the name of the exercise to perform.
     * @param exercise name of the exercise to perform.
@@ -0,0 +1,418 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file lstm.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include "lstm.h"
+
+using namespace std;
+
+namespace
+{
+    const char magic[4]={'L','S','T','M'};
+    const int32_t version=1;
+
+    //weights per output column left out of the 8-bit quantization
+    const int noutliers=3;
+
+    /********************************************************/
+    template<typename T>
+    bool readArray(ifstream &fin, vector<T> &v, const size_t n)
+    {
+        v.resize(n);
+        fin.read(reinterpret_cast<char*>(v.data()),n*sizeof(T));
+        return (bool)fin;
+    }
+
+    /********************************************************/
+    template<typename T>
+    void writeArray(ofstream &fout, const vector<T> &v)
+    {
+        fout.write(reinterpret_cast<const char*>(v.data()),v.size()*sizeof(T));
+    }
+
+    /********************************************************/
+    inline float sigmoid(const float x)
+    {
+        return 1.0f/(1.0f+exp(-x));
+    }
+
+    /********************************************************/
+    //acc+=z*W, with W stored input by output; the inner loop runs over
+    //contiguous outputs and gets vectorized
+    void gemv(const float *z, const int nin, const float *w, const int nout, float *acc)
+    {
+        for(int k=0; k<nin; k++)
+        {
+            const float zk=z[k];
+            const float *wk=w+(size_t)k*nout;
+            for(int j=0; j<nout; j++)
+            {
+                acc[j]+=zk*wk[j];
+            }
+        }
+    }
+
+    /********************************************************/
+    //as above, with 8-bit weights scaled per output plus the outliers
+    void gemv(const float *z, const int nin, const int8_t *q, const float *s,
+              const float *o, const int32_t *r, const int nout, float *tmp, float *acc)
+    {
+        fill(tmp,tmp+nout,0.0f);
+        for(int k=0; k<nin; k++)
+        {
+            const float zk=z[k];
+            const int8_t *qk=q+(size_t)k*nout;
+            for(int j=0; j<nout; j++)
+            {
+                tmp[j]+=zk*(float)qk[j];
+            }
+        }
+        for(int j=0; j<nout; j++)
+        {
+            float a=tmp[j]*s[j];
+            for(int n=0; n<noutliers; n++)
+            {
+                a+=z[r[j*noutliers+n]]*o[j*noutliers+n];
+            }
+            acc[j]+=a;
+        }
+    }
+
+    /********************************************************/
+    //with few inputs per column, the largest weights would coarsen the
+    //scale of all the others and the recurrence amplifies the rounding
+    //errors along the window: they are moved to o and kept in float
+    void quantize(const vector<float> &w, const int nin, const int nout,
+                  vector<int8_t> &q, vector<float> &s, vector<float> &o,
+                  vector<int32_t> &r)
+    {
+        vector<float> res(w);
+        o.assign((size_t)nout*noutliers,0.0f);
+        r.assign((size_t)nout*noutliers,0);
+        for(int j=0; j<nout; j++)
+        {
+            for(int n=0; n<std::min(noutliers,nin); n++)
+            {
+                int kmax=0;
+                for(int k=1; k<nin; k++)
+                {
+                    if(fabs(res[(size_t)k*nout+j])>fabs(res[(size_t)kmax*nout+j]))
+                    {
+                        kmax=k;
+                    }
+                }
+                o[j*noutliers+n]=res[(size_t)kmax*nout+j];
+                r[j*noutliers+n]=kmax;
+                res[(size_t)kmax*nout+j]=0.0f;
+            }
+        }
+
+        s.assign(nout,0.0f);
+        for(int k=0; k<nin; k++)
+        {
+            for(int j=0; j<nout; j++)
+            {
+                s[j]=std::max(s[j],fabs(res[(size_t)k*nout+j]));
+            }
+        }
+        for(int j=0; j<nout; j++)
+        {
+            s[j]=(s[j]>0.0f?s[j]/127.0f:1.0f);
+        }
+
+        q.resize(w.size());
+        for(int k=0; k<nin; k++)
+        {
+            for(int j=0; j<nout; j++)
+            {
+                size_t i=(size_t)k*nout+j;
+                q[i]=(int8_t)std::max(-127.0f,std::min(127.0f,round(res[i]/s[j])));
+            }
+        }
+    }
+}
+
+/********************************************************/
+LstmWeights::LstmWeights() : nfeatures(0), nembed(0), nhidden(0), nclasses(0),
+    forget_bias(1.0f)
+{
+
+}
+
+/********************************************************/
+bool LstmWeights::load(const string &file, string &error)
+{
+    ifstream fin(file,ios::binary);
+    if(!fin.is_open())
+    {
+        error="Unable to open "+file;
+        return false;
+    }
+
+    char m[4];
+    int32_t v,dims[5];
+    fin.read(m,sizeof(m));
+    fin.read(reinterpret_cast<char*>(&v),sizeof(v));
+    if(!fin || memcmp(m,magic,sizeof(m))!=0 || v!=version)
+    {
+        error=file+" is not a network exported by this version";
+        return false;
+    }
+
+    fin.read(reinterpret_cast<char*>(dims),sizeof(dims));
+    fin.read(reinterpret_cast<char*>(&forget_bias),sizeof(forget_bias));
+    if(!fin || *min_element(dims,dims+5)<=0)
+    {
+        error="Wrong sizes in "+file;
+        return false;
+    }
+    nfeatures=dims[0];
+    nembed=dims[1];
+    nhidden=dims[2];
+    nclasses=dims[4];
+
+    bool ok=readArray(fin,wembed,(size_t)nfeatures*nembed) &&
+            readArray(fin,bembed,nembed);
+    kernels.resize(dims[3]);
+    biases.resize(dims[3]);
+    for(int l=0; l<dims[3]; l++)
+    {
+        int nin=(l==0?nembed:nhidden);
+        ok=ok && readArray(fin,kernels[l],(size_t)(nin+nhidden)*4*nhidden) &&
+                 readArray(fin,biases[l],4*nhidden);
+    }
+    ok=ok && readArray(fin,wout,(size_t)nhidden*nclasses) &&
+             readArray(fin,bout,nclasses);
+    if(!ok)
+    {
+        error=file+" is truncated";
+    }
+    return ok;
+}
+
+/********************************************************/
+bool LstmWeights::save(const string &file) const
+{
+    ofstream fout(file,ios::binary);
+    if(!fout.is_open())
+    {
+        return false;
+    }
+
+    int32_t dims[5]={nfeatures,nembed,nhidden,(int32_t)kernels.size(),nclasses};
+    fout.write(magic,sizeof(magic));
+    fout.write(reinterpret_cast<const char*>(&version),sizeof(version));
+    fout.write(reinterpret_cast<const char*>(dims),sizeof(dims));
+    fout.write(reinterpret_cast<const char*>(&forget_bias),sizeof(forget_bias));
+    writeArray(fout,wembed);
+    writeArray(fout,bembed);
+    for(size_t l=0; l<kernels.size(); l++)
+    {
+        writeArray(fout,kernels[l]);
+        writeArray(fout,biases[l]);
+    }
+    writeArray(fout,wout);
+    writeArray(fout,bout);
+    return (bool)fout;
+}
+
+/********************************************************/
+Lstm::Lstm(const bool quantized) : quantized(quantized)
+{
+
+}
+
+/********************************************************/
+bool Lstm::load(const string &model)
+{
+    LstmWeights w;
+    if(!w.load(model+".bin",error))
+    {
+        return false;
+    }
+
+    //the kernel acting on [x,h] is split, so that the input part is
+    //evaluated over the whole window at once
+    int ngates=4*w.nhidden;
+    layers.resize(w.kernels.size());
+    for(size_t l=0; l<layers.size(); l++)
+    {
+        Layer &layer=layers[l];
+        layer.ninput=(l==0?w.nembed:w.nhidden);
+        const vector<float> &k=w.kernels[l];
+        layer.wx.assign(k.begin(),k.begin()+(size_t)layer.ninput*ngates);
+        layer.wh.assign(k.begin()+(size_t)layer.ninput*ngates,k.end());
+        layer.bias=w.biases[l];
+
+        //the forget bias is added once and for all
+        for(int j=2*w.nhidden; j<3*w.nhidden; j++)
+        {
+            layer.bias[j]+=w.forget_bias;
+        }
+
+        if(quantized)
+        {
+            quantize(layer.wx,layer.ninput,ngates,layer.qx,layer.sx,layer.ox,layer.rx);
+            quantize(layer.wh,w.nhidden,ngates,layer.qh,layer.sh,layer.oh,layer.rh);
+
+            //only the 8-bit kernels are used from now on
+            vector<float>().swap(layer.wx);
+            vector<float>().swap(layer.wh);
+        }
+    }
+
+    //the layers hold their own copy of the kernels
+    vector<vector<float>>().swap(w.kernels);
+    vector<vector<float>>().swap(w.biases);
+    weights=move(w);
+    return true;
+}
+
+/********************************************************/
+void Lstm::run(const float *window, const int nframes, float *scores)
+{
+    const int nh=weights.nhidden;
+    const int ngates=4*nh;
+
+    //dense relu layer, frame by frame
+    seq.resize((size_t)nframes*weights.nembed);
+    for(int t=0; t<nframes; t++)
+    {
+        float *e=&seq[(size_t)t*weights.nembed];
+        copy(weights.bembed.begin(),weights.bembed.end(),e);
+        gemv(window+(size_t)t*weights.nfeatures,weights.nfeatures,
+             weights.wembed.data(),weights.nembed,e);
+        for(int j=0; j<weights.nembed; j++)
+        {
+            e[j]=std::max(e[j],0.0f);
+        }
+    }
+
+    h.resize(nh);
+    c.resize(nh);
+    gates.resize(ngates);
+    acc.resize(ngates);
+    for(size_t l=0; l<layers.size(); l++)
+    {
+        const Layer &layer=layers[l];
+        bool last=(l+1==layers.size());
+
+        //input contributions of all frames, bias included
+        xgates.resize((size_t)nframes*ngates);
+        for(int t=0; t<nframes; t++)
+        {
+            float *g=&xgates[(size_t)t*ngates];
+            copy(layer.bias.begin(),layer.bias.end(),g);
+            const float *x=&seq[(size_t)t*layer.ninput];
+            if(quantized)
+            {
+                gemv(x,layer.ninput,layer.qx.data(),layer.sx.data(),layer.ox.data(),
+                     layer.rx.data(),ngates,acc.data(),g);
+            }
+            else
+            {
+                gemv(x,layer.ninput,layer.wx.data(),ngates,g);
+            }
+        }
+
+        fill(h.begin(),h.end(),0.0f);
+        fill(c.begin(),c.end(),0.0f);
+        if(!last)
+        {
+            next.resize((size_t)nframes*nh);
+        }
+        for(int t=0; t<nframes; t++)
+        {
+            const float *xg=&xgates[(size_t)t*ngates];
+            copy(xg,xg+ngates,gates.begin());
+            if(quantized)
+            {
+                gemv(h.data(),nh,layer.qh.data(),layer.sh.data(),layer.oh.data(),
+                     layer.rh.data(),ngates,acc.data(),gates.data());
+            }
+            else
+            {
+                gemv(h.data(),nh,layer.wh.data(),ngates,gates.data());
+            }
+
+            //all gates in one go
+            const float *gi=&gates[0];
+            const float *gj=&gates[nh];
+            const float *gf=&gates[2*nh];
+            const float *go=&gates[3*nh];
+            for(int j=0; j<nh; j++)
+            {
+                c[j]=c[j]*sigmoid(gf[j])+sigmoid(gi[j])*tanh(gj[j]);
+                h[j]=tanh(c[j])*sigmoid(go[j]);
+            }
+            if(!last)
+            {
+                copy(h.begin(),h.end(),next.begin()+(size_t)t*nh);
+            }
+        }
+        if(!last)
+        {
+            seq.swap(next);
+        }
+    }
+
+    //dense layer on the last output
+    copy(weights.bout.begin(),weights.bout.end(),scores);
+    gemv(h.data(),nh,weights.wout.data(),weights.nclasses,scores);
+}
+
+/********************************************************/
+bool Lstm::classify(const float *windows, const int n, const int nframes,
+                    const int nfeatures, vector<float> &scores)
+{
+    if(layers.empty())
+    {
+        error="No network loaded";
+        return false;
+    }
+    if(nfeatures!=weights.nfeatures)
+    {
+        error="The network expects "+to_string(weights.nfeatures)+" features";
+        return false;
+    }
+
+    scores.resize((size_t)n*weights.nclasses);
+    for(int b=0; b<n; b++)
+    {
+        run(windows+(size_t)b*nframes*weights.nfeatures,nframes,
+            &scores[(size_t)b*weights.nclasses]);
+    }
+    return true;
+}
+
+/********************************************************/
+size_t Lstm::getFootprint() const
+{
+    size_t bytes=(weights.wembed.size()+weights.bembed.size()+
+                  weights.wout.size()+weights.bout.size())*sizeof(float);
+    for(auto &l:layers)
+    {
+        bytes+=(l.wx.size()+l.wh.size()+l.bias.size()+l.sx.size()+l.sh.size()+
+                l.ox.size()+l.oh.size())*sizeof(float);
+        bytes+=l.qx.size()+l.qh.size()+(l.rx.size()+l.rh.size())*sizeof(int32_t);
+    }
+    return bytes;
+}
+
+/********************************************************/
+Classifier *createNativeClassifier(const bool quantized)
+{
+    return new Lstm(quantized);
+}
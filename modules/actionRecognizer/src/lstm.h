@@ -0,0 +1,78 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file lstm.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __LSTM_H__
+#define __LSTM_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "classifier.h"
+
+//weights of the trained network: a dense relu layer, a stack of LSTM
+//layers and a dense layer on the last output, stored as in Tensorflow
+//(input by output, gates in the order i,j,f,o)
+struct LstmWeights
+{
+    int nfeatures,nembed,nhidden,nclasses;
+    float forget_bias;
+    std::vector<float> wembed,bembed;
+    std::vector<std::vector<float>> kernels,biases;
+    std::vector<float> wout,bout;
+
+    LstmWeights();
+
+    //flat little-endian binary file, as written by the exporter
+    bool load(const std::string &file, std::string &error);
+    bool save(const std::string &file) const;
+};
+
+//CPU inference of the network above
+class Lstm : public Classifier
+{
+    struct Layer
+    {
+        int ninput;
+
+        //input and recurrent weights with the four gates side by side;
+        //in 8-bit precision, each output column has its own scale and
+        //its largest weights are kept apart in float, along with their rows
+        std::vector<float> wx,wh,bias;
+        std::vector<int8_t> qx,qh;
+        std::vector<float> sx,sh,ox,oh;
+        std::vector<int32_t> rx,rh;
+    };
+
+    LstmWeights weights;
+    std::vector<Layer> layers;
+    bool quantized;
+    std::string error;
+
+    //scratch buffers, kept across windows
+    std::vector<float> seq,next,xgates,gates,acc,h,c;
+
+    void run(const float *window, const int nframes, float *scores);
+
+public:
+    Lstm(const bool quantized=false);
+
+    bool load(const std::string &model) override;
+    bool classify(const float *windows, const int n, const int nframes,
+                  const int nfeatures, std::vector<float> &scores) override;
+    std::string getError() const override { return error; }
+    size_t getFootprint() const override;
+
+    int getNumFeatures() const { return weights.nfeatures; }
+    int getNumClasses() const { return weights.nclasses; }
+};
+
+#endif
@@ -15,23 +15,23 @@
 #include <fstream>
 #include <cmath>
 #include <algorithm>
+#include <deque>
+#include <map>
+#include <condition_variable>
+#include <memory>
 #include <yarp/os/all.h>
 #include <yarp/sig/Matrix.h>
 #include <yarp/math/Math.h>
-#include <boost/algorithm/string.hpp>
-#include <tensorflow/core/public/session.h>
-#include <tensorflow/core/protobuf/meta_graph.pb.h>
-#include <tensorflow/cc/client/client_session.h>
-#include <tensorflow/cc/ops/standard_ops.h>
-#include <tensorflow/cc/ops/array_ops.h>
 #include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/opcClient.h"
+#include "classifier.h"
+#include "modelcache.h"
 #include "src/actionRecognizer_IDL.h"
 
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::sig;
 using namespace yarp::math;
-using namespace tensorflow;
 using namespace assistive_rehab;
 
 /****************************************************************/
@@ -42,24 +42,55 @@ class Recognizer : public RFModule, public actionRecognizer_IDL
     unordered_map<int,string> class_map;
     int nframes,nsteps,nclasses,nfeatures;
     string part;
-    string skel_tag;
     string model_name;
-    SkeletonStd skeletonIn;
-
-    bool predict,updated;
-    int idx_frame,idx_step;
-    string pathToGraph,checkpointPath;
-    Status status;
-    Tensor input;
-    Session* session;
-    SessionOptions sess_opts;
-    vector<string> predictions;
-    vector<float> outscores;
+
+    bool predict;
+    string backend;
+    int intra_op,inter_op;
+    int warmup_frames;
+
+    //networks of the parts are kept loaded, the one in use is shared
+    //with the inference thread
+    ModelCache models;
+    std::mutex models_mtx;
+    shared_ptr<Classifier> classifier;
     Matrix T;
 
+    //each followed skeleton keeps the latest nframes frames, the oldest
+    //one at head, and the predictions taking part in its vote
+    struct Subject
+    {
+        SkeletonStd skeleton;
+        bool updated;
+        vector<float> frames;
+        int head,nacquired,since_inference;
+        deque<pair<string,float>> votes;
+        unordered_map<string,int> nvotes;
+    };
+    map<string,Subject> subjects;
+    int stride;
+
+    //windows of all subjects are gathered in one buffer, and evaluated
+    //in one go by the inference thread while the other buffer fills up
+    class Worker : public yarp::os::Thread
+    {
+        Recognizer *recognizer;
+    public:
+        Worker(Recognizer *recognizer_) : recognizer(recognizer_) { }
+        void run() override { recognizer->inferenceLoop(); }
+    };
+    vector<float> due,due_worker;
+    vector<string> due_tags,due_tags_worker;
+    int ndue,ndue_worker,nframes_worker;
+    int generation,generation_worker;
+    bool pending,closing,batching;
+    std::mutex infer_mtx,classifier_mtx;
+    std::condition_variable cv_infer;
+    Worker *worker;
+
     RpcServer analyzerPort;
     BufferedPort<Bottle> outPort;
-    RpcClient opcPort;
+    OpcClient opc;
 
     std::mutex mtx;
     bool starting;
@@ -75,6 +106,16 @@ public:
         string moduleName = rf.check("name", Value("actionRecognizer")).asString();
         setName(moduleName.c_str());
         predict = rf.check("predict",Value(true)).asBool();
+        stride = rf.check("stride",Value(0)).asInt();
+        warmup_frames = rf.check("warmup-frames",Value(30)).asInt();
+        backend = rf.check("backend",Value("tensorflow")).asString();
+        if(!opc.open("/" + moduleName + "/opc",rf.check("opc-mode",Value("rpc")).asString()))
+        {
+            yError() << "Unable to open the opc client, check opc-mode";
+            return false;
+        }
+        intra_op = rf.check("intra-op-threads",Value(0)).asInt();
+        inter_op = rf.check("inter-op-threads",Value(0)).asInt();
         Bottle &bGroup=rf.findGroup("general");
         if (bGroup.isNull())
         {
@@ -125,131 +166,160 @@ public:
         keypoint2int[KeyPointTag::hip_center] = 18;
         keypoint2int[KeyPointTag::shoulder_center] = 20;
         
-        skel_tag = " ";
         starting = false;
-        idx_step=0;
+        nframes = 0;
+        ndue = ndue_worker = nframes_worker = 0;
+        generation = generation_worker = 0;
+        pending = closing = false;
+        batching = true;
 
-        // Set up input paths
-        pathToGraph = rf.findFileByName(model_name+"_"+part+".meta");
-        checkpointPath = pathToGraph.substr(0, pathToGraph.find_last_of("/\\")) + "/" + model_name + "_" + part;
+        worker = nullptr;
         if(predict)
         {
-            yInfo() << "Loading model from:" << pathToGraph;
-
-            sess_opts.config.mutable_gpu_options()->set_allow_growth(true); //to limit GPU usage
-            session = NewSession(sess_opts);
-            if (session == nullptr)
-            {
-                throw runtime_error("Could not create Tensorflow session");
-                return false;
-            }
+            double budget = rf.check("model-cache-mb",Value(0.0)).asDouble();
+            models.configure([this](const string &part) { return openClassifier(part); },
+                             (size_t)(std::max(budget,0.0)*1024.0*1024.0));
 
-            // Read in the protobuf graph we exported
-            MetaGraphDef graph_def;
-            status = ReadBinaryProto(Env::Default(), pathToGraph, &graph_def);
-            if (!status.ok())
+            //other parts are loaded upfront, so that switching costs nothing
+            if(Bottle *preload = rf.find("preload").asList())
             {
-                throw runtime_error("Error reading graph definition from " + pathToGraph + ": " + status.ToString());
-                return false;
-            }
-
-            // Add the graph to the session
-            status = session->Create(graph_def.graph_def());
-            if (!status.ok())
-            {
-                throw runtime_error("Error creating graph: " + status.ToString());
-                return false;
+                for(int i=0; i<preload->size(); i++)
+                {
+                    string p = preload->get(i).asString();
+                    if(p != part && !models.get(p))
+                    {
+                        yWarning() << "Unable to preload the model of" << p;
+                    }
+                }
             }
 
-            // Read weights from the saved checkpoint
-            Tensor checkpointPathTensor(DT_STRING, TensorShape());
-            checkpointPathTensor.scalar<std::string>()() = checkpointPath;
-            status = session->Run(
-                    {{ graph_def.saver_def().filename_tensor_name(), checkpointPathTensor },},
-                    {},
-                    {graph_def.saver_def().restore_op_name()},
-                    nullptr);
-            if (!status.ok())
+            classifier = models.get(part);
+            if(!classifier)
             {
-                throw runtime_error("Error loading checkpoint from " + checkpointPath + ": " + status.ToString());
                 return false;
             }
+            yInfo() << models.size() << "models loaded, taking"
+                    << models.getFootprint()/1024 << "KB";
         }
 
+        worker = new Worker(this);
+        worker->start();
+
         analyzerPort.open("/" + moduleName + "/rpc");
-        opcPort.open("/" + moduleName + "/opc");
         outPort.open("/" + moduleName + "/target:o");
         attach(analyzerPort);
         return true;
     }
 
     /**********************************************************/
-    bool loadModel(const string &part_) override
+    Classifier *openClassifier(const string &part)
     {
-        lock_guard<std::mutex> lg(mtx);
+        Classifier *classifier = nullptr;
+        string ext;
+        if(backend == "native" || backend == "native-int8")
+        {
+            classifier = createNativeClassifier(backend == "native-int8");
+            ext = ".bin";
+        }
+        else if(backend == "tensorflow")
+        {
+            classifier = createTensorflowClassifier(intra_op,inter_op);
+            ext = ".meta";
+            if(classifier == nullptr)
+            {
+                yWarning() << "Built without Tensorflow, switching to the native backend";
+                backend = "native";
+                classifier = createNativeClassifier(false);
+                ext = ".bin";
+            }
+        }
+        if(classifier == nullptr)
+        {
+            yError() << "Backend" << backend << "is not available";
+            return nullptr;
+        }
 
         // Set up input paths
-        part = part_;
-        pathToGraph = rf.findFileByName(model_name+"_"+part+".meta");
-        checkpointPath = pathToGraph.substr(0, pathToGraph.find_last_of("/\\")) + "/" + model_name + "_" +part;
-        if(predict)
+        string path = rf.findFileByName(model_name+"_"+part+ext);
+        string model = path.substr(0, path.size()-ext.size());
+        yInfo() << "Loading model from:" << path;
+        if(!classifier->load(model))
         {
-            yInfo() << "Loading model from:" << pathToGraph;
+            yError() << classifier->getError();
+            delete classifier;
+            return nullptr;
+        }
 
-            sess_opts.config.mutable_gpu_options()->set_allow_growth(true); //to limit GPU usage
-            session = NewSession(sess_opts);
-            if (session == nullptr)
+        //the first run allocates and optimizes, hence it is paid here
+        //rather than by the first prediction
+        if(warmup_frames > 0)
+        {
+            vector<float> zeros(warmup_frames*nfeatures,0.0f),scores;
+            double t0 = Time::now();
+            if(classifier->classify(zeros.data(),1,warmup_frames,nfeatures,scores))
             {
-                throw runtime_error("Could not create Tensorflow session");
-                return false;
+                yInfo() << "Warm-up run took" << Time::now()-t0 << "s";
             }
-
-            // Read in the protobuf graph we exported
-            MetaGraphDef graph_def;
-            status = ReadBinaryProto(Env::Default(), pathToGraph, &graph_def);
-            if (!status.ok())
+            else
             {
-                throw runtime_error("Error reading graph definition from " + pathToGraph + ": " + status.ToString());
-                return false;
+                yWarning() << "Warm-up run failed:" << classifier->getError();
             }
+        }
 
-            // Add the graph to the session
-            status = session->Create(graph_def.graph_def());
-            if (!status.ok())
-            {
-                throw runtime_error("Error creating graph: " + status.ToString());
-                return false;
-            }
+        return classifier;
+    }
 
-            // Read weights from the saved checkpoint
-            Tensor checkpointPathTensor(DT_STRING, TensorShape());
-            checkpointPathTensor.scalar<std::string>()() = checkpointPath;
-            status = session->Run(
-                    {{ graph_def.saver_def().filename_tensor_name(), checkpointPathTensor },},
-                    {},
-                    {graph_def.saver_def().restore_op_name()},
-                    nullptr);
-            if (!status.ok())
+    /**********************************************************/
+    bool loadModel(const string &part_) override
+    {
+        //loaded only the first time the part is requested, without
+        //holding the module lock, hence acquisition goes on meanwhile
+        shared_ptr<Classifier> classifier_;
+        if(predict)
+        {
+            lock_guard<std::mutex> lg_models(models_mtx);
+            classifier_ = models.get(part_);
+            if(!classifier_)
             {
-                throw runtime_error("Error loading checkpoint from " + checkpointPath + ": " + status.ToString());
                 return false;
             }
         }
 
+        //the model in use is replaced once ready
+        lock_guard<std::mutex> lg(mtx);
+        part = part_;
+        if(classifier_)
+        {
+            lock_guard<std::mutex> lg_classifier(classifier_mtx);
+            classifier.swap(classifier_);
+            batching = true;
+        }
+
         return true;
     }
 
     /**********************************************************/
     bool close() override
     {
-        if(predict)
         {
-            session->Close();
-            delete session;
+            lock_guard<std::mutex> lg(infer_mtx);
+            closing = true;
+        }
+        cv_infer.notify_all();
+        if(worker != nullptr)
+        {
+            worker->stop();
+            delete worker;
         }
-               
+
+        classifier.reset();
+        {
+            lock_guard<std::mutex> lg(models_mtx);
+            models.clear();
+        }
+
         analyzerPort.close();
-        opcPort.close();
+        opc.close();
         outPort.close();
         return true;
     }
@@ -271,36 +341,67 @@ public:
     {
         lock_guard<std::mutex> lg(mtx);
         nframes = (int)nframes_;
-        input = Tensor(DT_FLOAT, TensorShape({1,nframes,nfeatures}));
-        idx_frame = 0;
-        resetTensor();
-        predictions.clear();
-        outscores.clear();
+        for(auto &s:subjects)
+        {
+            reset(s.second);
+        }
+        ndue = 0;
+        due_tags.clear();
+        generation++;
 
         starting = true;
         return starting;
     }
-    
-     /****************************************************************/
-    void resetTensor()
-    {
-		for(size_t i=0; i<nframes; i++)
-        {
-            for(size_t j=0; j<nfeatures; j++)
-            {
-                input.tensor<float,3>()(0,i,j) = 0.0;
-            }
-        }		
-	}
 
     /****************************************************************/
     bool tags(const string &skel_tag_) override
     {
         lock_guard<std::mutex> lg(mtx);
-        skel_tag = skel_tag_;
+        subjects.clear();
+        reset(subjects[skel_tag_]);
+        return true;
+    }
+
+    /****************************************************************/
+    bool addTag(const string &skel_tag_) override
+    {
+        lock_guard<std::mutex> lg(mtx);
+        if(subjects.find(skel_tag_) == subjects.end())
+        {
+            reset(subjects[skel_tag_]);
+        }
         return true;
     }
 
+    /****************************************************************/
+    bool removeTag(const string &skel_tag_) override
+    {
+        lock_guard<std::mutex> lg(mtx);
+        return (subjects.erase(skel_tag_) > 0);
+    }
+
+    /****************************************************************/
+    vector<string> getTags() override
+    {
+        lock_guard<std::mutex> lg(mtx);
+        vector<string> tags;
+        for(auto &s:subjects)
+        {
+            tags.push_back(s.first);
+        }
+        return tags;
+    }
+
+    /****************************************************************/
+    void reset(Subject &subject)
+    {
+        subject.updated = false;
+        subject.frames.assign(nframes*nfeatures,0.0f);
+        subject.head = subject.nacquired = subject.since_inference = 0;
+        subject.votes.clear();
+        subject.nvotes.clear();
+    }
+
     /****************************************************************/
     bool load(const string &exercise) override
     {
@@ -324,76 +425,262 @@ public:
     {
         lock_guard<std::mutex> lg(mtx);
         starting = false;
-        skel_tag = " ";
-        idx_step = 0;
+        subjects.clear();
+        ndue = 0;
+        due_tags.clear();
+        generation++;
         cout << endl;
         cout << endl;
         return !starting;
     }
 
     /****************************************************************/
-    bool updateInput(const string & tag, const int i, const float &x, const float &y)
-   {
+    bool updateInput(const string & tag, float *frame, const float &x, const float &y)
+    {
         int j = keypoint2int[tag];
-        input.tensor<float,3>()(0,i,j) = x/10.0;
-        input.tensor<float,3>()(0,i,j+1) = y/10.0;
+        frame[j] = x/10.0;
+        frame[j+1] = y/10.0;
         return true;
     }
 
-    /********************************************************/
-    void getSkeleton()
+    /****************************************************************/
+    void pushFrame(const string &tag, Subject &subject)
+    {
+        int &head=subject.head;
+        head=(head+1)%nframes;
+        subject.nacquired=std::min(subject.nacquired+1,nframes);
+        subject.since_inference++;
+
+        //without a stride, windows do not overlap
+        int k=(stride>0?stride:nframes);
+        if(subject.nacquired==nframes && subject.since_inference>=k)
+        {
+            //the window is unrolled from the oldest frame
+            const vector<float> &frames=subject.frames;
+            size_t len=nframes*nfeatures;
+            due.resize((ndue+1)*len);
+            float *window=&due[ndue*len];
+            copy(frames.begin()+head*nfeatures,frames.end(),window);
+            copy(frames.begin(),frames.begin()+head*nfeatures,window+(nframes-head)*nfeatures);
+            due_tags.push_back(tag);
+            ndue++;
+            subject.since_inference=0;
+        }
+    }
+
+    /****************************************************************/
+    void handOver()
+    {
+        lock_guard<std::mutex> lg(infer_mtx);
+
+        //if the thread is still busy, windows keep on piling up
+        if(!pending)
+        {
+            due.swap(due_worker);
+            due_tags.swap(due_tags_worker);
+            due_tags.clear();
+            ndue_worker = ndue;
+            nframes_worker = nframes;
+            generation_worker = generation;
+            ndue = 0;
+            pending = true;
+            cv_infer.notify_one();
+        }
+    }
+
+    /****************************************************************/
+    void inferenceLoop()
+    {
+        std::unique_lock<std::mutex> lck(infer_mtx);
+        while(true)
+        {
+            cv_infer.wait(lck,[this]() { return closing || pending; });
+            if(closing)
+            {
+                return;
+            }
+
+            lck.unlock();
+            inferDue(due_worker.data(),due_tags_worker,ndue_worker,nframes_worker,generation_worker);
+            lck.lock();
+            pending = false;
+        }
+    }
+
+    /****************************************************************/
+    bool infer(const float *windows, const int n, const int nframes,
+               vector<int> &pred, vector<float> &scores)
     {
-        //ask for the property id
-        Bottle cmd, reply;
-        cmd.addVocab(Vocab::encode("ask"));
-        Bottle &content = cmd.addList().addList();
-        content.addString("skeleton");
-        opcPort.write(cmd, reply);
-        if(reply.size() > 1)
-        {
-            if(reply.get(0).asVocab() == Vocab::encode("ack"))
+        if(!classifier->classify(windows,n,nframes,nfeatures,scores))
+        {
+            return false;
+        }
+
+        //the class with highest score, which is normalized through softmax
+        pred.resize(n);
+        for(int b=0; b<n; b++)
+        {
+            float *score=&scores[b*nclasses];
+            float norm=0.0;
+            pred[b]=0;
+            for(int k=0; k<nclasses; k++)
             {
-                if(Bottle *idField = reply.get(1).asList())
+                norm+=exp(score[k]);
+                if(score[k]>score[pred[b]])
                 {
-                    if(Bottle *idValues = idField->get(1).asList())
-                    {
-                        if(!skel_tag.empty())
-                        {
-                            updated=false;
-                            for(int i=0; i<idValues->size(); i++)
-                            {
-                                int id = idValues->get(i).asInt();
-
-                                //given the id, get the value of the property
-                                cmd.clear();
-                                cmd.addVocab(Vocab::encode("get"));
-                                Bottle &content = cmd.addList().addList();
-                                Bottle replyProp;
-                                content.addString("id");
-                                content.addInt(id);
-                                opcPort.write(cmd, replyProp);
-                                if(replyProp.get(0).asVocab() == Vocab::encode("ack"))
-                                {
-                                    if(Bottle *propField = replyProp.get(1).asList())
-                                    {
-                                        Property prop(propField->toString().c_str());
-                                        string tag=prop.find("tag").asString();
-                                        if(!tag.empty())
-                                        {
-                                            if(prop.check("tag") && tag==skel_tag)
-                                            {
-                                                Skeleton* skeleton = skeleton_factory(prop);
-                                                skeletonIn.update(skeleton->toProperty());
-                                                updated=true;
-                                                delete skeleton;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    pred[b]=k;
+                }
+            }
+            for(int k=0; k<nclasses; k++)
+            {
+                score[k]=exp(score[k])/norm;
+            }
+        }
+        return true;
+    }
+
+    /****************************************************************/
+    void inferDue(const float *due, const vector<string> &tags, const int ndue,
+                  const int nframes, const int generation)
+    {
+        vector<int> pred;
+        vector<float> scores;
+        bool ok=true;
+        if(predict)
+        {
+            //the module lock is not held, acquisition goes on meanwhile
+            lock_guard<std::mutex> lg(classifier_mtx);
+
+            //windows of all subjects make up one batch; fall back to one
+            //window at a time if the graph does not batch
+            ok=false;
+            if(batching || ndue==1)
+            {
+                ok=infer(due,ndue,nframes,pred,scores);
+                if(!ok && ndue>1)
+                {
+                    yWarning() << "Unable to infer a batch of windows:" << classifier->getError();
+                    batching=false;
+                }
+            }
+            if(!ok && ndue>1)
+            {
+                vector<int> p;
+                vector<float> s;
+                size_t len=nframes*nfeatures;
+                ok=true;
+                pred.clear();
+                scores.clear();
+                for(int b=0; b<ndue && ok; b++)
+                {
+                    ok=infer(&due[b*len],1,nframes,p,s);
+                    pred.insert(pred.end(),p.begin(),p.end());
+                    scores.insert(scores.end(),s.begin(),s.end());
+                }
+            }
+            if(!ok)
+            {
+                yError() << "Unable to run the inference:" << classifier->getError();
+            }
+        }
+
+        lock_guard<std::mutex> lg(mtx);
+
+        //windows acquired before a restart do not vote
+        if(!ok || generation!=this->generation)
+        {
+            return;
+        }
+
+        for(int b=0; b<ndue; b++)
+        {
+            //the subject may have been dropped meanwhile
+            auto it=subjects.find(tags[b]);
+            if(it==subjects.end())
+            {
+                continue;
+            }
+
+            string action=action_to_perform;
+            float score=1.0;
+            if(predict)
+            {
+                string label=class_map[pred[b]];
+                if(label!="random" && label!="static")
+                {
+                    action=label+"_"+part;
+                }
+                else
+                {
+                    action=label;
                 }
+                score=scores[b*nclasses+pred[b]];
+                yDebug() << tags[b] << "prediction:" << label << "score:" << score;
+            }
+            vote(it->first,it->second,action,score);
+        }
+    }
+
+    /****************************************************************/
+    void vote(const string &tag, Subject &subject, const string &action, const float score)
+    {
+        deque<pair<string,float>> &votes=subject.votes;
+        unordered_map<string,int> &nvotes=subject.nvotes;
+        votes.push_back(make_pair(action,score));
+        nvotes[action]++;
+        if(votes.size()>nsteps)
+        {
+            nvotes[votes.front().first]--;
+            votes.pop_front();
+        }
+        if(votes.size()<nsteps)
+        {
+            return;
+        }
+
+        //we consider the most voted action, the earliest on ties
+        int max=0;
+        string voted_action;
+        float voted_score=0.0;
+        for(auto &v:votes)
+        {
+            int n=nvotes[v.first];
+            if(n>max)
+            {
+                max=n;
+                voted_action=v.first;
+                voted_score=v.second;
+            }
+        }
+        yInfo() << "The most voted action for" << tag << "is" << voted_action
+                << "voted" << max << "times";
+
+        //several subjects may vote at once, none is dropped
+        Bottle &outBottle = outPort.prepare();
+        outBottle.clear();
+        outBottle.addString(action_to_perform);
+        outBottle.addString(voted_action);
+        outBottle.addDouble(voted_score);
+        outBottle.addString(tag);
+        outPort.writeStrict();
+
+        //without a stride, votes do not overlap either
+        if(stride<=0)
+        {
+            votes.clear();
+            nvotes.clear();
+        }
+    }
+
+    /********************************************************/
+    void getSkeleton()
+    {
+        if(!subjects.empty())
+        {
+            opc.refresh();
+            for(auto &s:subjects)
+            {
+                s.second.updated=opc.getSkeleton(s.first,s.second.skeleton);
             }
         }
     }
@@ -402,13 +689,22 @@ public:
     bool updateModule() override
     {
         lock_guard<std::mutex> lg(mtx);
-        if(opcPort.getOutputCount() > 0 && starting)
+        if(opc.isConnected() && starting)
         {
             getSkeleton();
 
-            if(updated)
+            for(auto &s:subjects)
             {
+                Subject &subject=s.second;
+                if(!subject.updated || nframes<=0)
+                {
+                    continue;
+                }
+
+                SkeletonStd &skeletonIn=subject.skeleton;
                 skeletonIn.normalize();
+                float *frame=&subject.frames[subject.head*nfeatures];
+                fill(frame,frame+nfeatures,0.0f);
                 for(size_t i=0; i<skeletonIn.getNumKeyPoints(); i++)
                 {
                     string tagjoint=skeletonIn[i]->getTag();
@@ -421,100 +717,19 @@ public:
                         Vector transf_p=T*p;
                         float x=transf_p[1];
                         float y=transf_p[2];
-                        updateInput(tagjoint,idx_frame,x,y);
+                        updateInput(tagjoint,frame,x,y);
                     }
                 }
-                if(idx_frame < nframes)
+                if(subject.nacquired<nframes && subject.nacquired%10==0)
                 {
-                    if(idx_frame%10==0)
-                        yInfo() << "Acquiring frame" << idx_frame;
-                    idx_frame++;
+                    yInfo() << "Acquiring frame" << subject.nacquired << "of" << s.first;
                 }
-                else
-                {
-                    string predicted_action;
-                    float outscore;
-                    if(predict)
-                    {
-                        //run the inference
-                        //                cout << (input).tensor<float, (3)>() << endl;
-                        cout << "input: " << input.DebugString() << endl;
-                        string input_layer = "x:0";
-                        vector<string> output_layers = {"add_1:0","ArgMax:0"};
-                        vector<Tensor> outputTensors;
-                        status = session->Run({{input_layer, input}}, {output_layers}, {}, &outputTensors);
-                        cout << "add_1: " << outputTensors[0].DebugString() << endl;
-                        cout << "ArgMax: " << outputTensors[1].DebugString() << endl;
-
-                        auto score = outputTensors[0].tensor<float,2>();
-                        auto out = outputTensors[1].scalar<int64>();
-                        int pred = out(0);
-                        cout << "prediction: " << pred << " " << class_map[pred] << endl;
-                        cout << "scores: ";
-                        float n=0.0;
-                        vector<float> scores(nclasses,0.0);
-                        for(size_t k=0; k<nclasses; k++)
-                            n+=exp(score(k));
-                        for(size_t k=0; k<nclasses; k++)
-                        {
-                            scores[k]=exp(score(k))/n;
-                            cout << scores[k] << " ";
-                        }
-                        cout << endl;
-                        if(class_map[pred]!="random" && class_map[pred]!="static")
-                        {
-                            predicted_action=class_map[pred]+"_"+part;
-                        }
-                        else
-                        {
-                            predicted_action=class_map[pred];
-                        }
-                        outscore=scores[pred];
-                        predictions.push_back(predicted_action);
-                        outscores.push_back(outscore);
-                        resetTensor();
-                    }
-                    else
-                    {
-                        predicted_action=action_to_perform;
-                        outscore=1.0;
-                        predictions.push_back(predicted_action);
-                        outscores.push_back(outscore);
-                    }
-
-                    idx_frame=0;
-                    idx_step++;
+                pushFrame(s.first,subject);
+            }
 
-                    if(idx_step==nsteps)
-                    {
-                        //we consider the most voted action
-                        int max=count(predictions.begin(),predictions.end(),predictions.at(0));
-                        string voted_action=predictions[0];
-                        float voted_score=outscores[0];
-                        for(size_t i=1; i<predictions.size(); i++)
-                        {
-                            int temp=count(predictions.begin(),predictions.end(),predictions.at(i));
-                            if(temp>max)
-                            {
-                                max=temp;
-                                voted_action=predictions[i];
-                                voted_score=outscores[i];
-                            }
-                        }
-                        yInfo() << "The most voted action is" << voted_action << "voted" << max << "times";
-
-                        Bottle &outBottle = outPort.prepare();
-                        outBottle.clear();
-                        outBottle.addString(action_to_perform);
-                        outBottle.addString(voted_action);
-                        outBottle.addDouble(voted_score);
-                        outPort.write();
-
-                        idx_step=0;
-                        predictions.clear();
-                        outscores.clear();
-                    }
-                }
+            if(ndue>0)
+            {
+                handOver();
             }
         }
 
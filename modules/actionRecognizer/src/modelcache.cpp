@@ -0,0 +1,85 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file modelcache.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include "modelcache.h"
+
+using namespace std;
+
+/********************************************************/
+ModelCache::ModelCache() : budget(0), footprint(0)
+{
+
+}
+
+/********************************************************/
+void ModelCache::configure(const Loader &loader, const size_t budget)
+{
+    clear();
+    this->loader=loader;
+    this->budget=budget;
+}
+
+/********************************************************/
+shared_ptr<Classifier> ModelCache::get(const string &part)
+{
+    auto it=entries.find(part);
+    if(it!=entries.end())
+    {
+        lru.splice(lru.begin(),lru,it->second.lru);
+        return it->second.classifier;
+    }
+
+    if(!loader)
+    {
+        return nullptr;
+    }
+    shared_ptr<Classifier> classifier(loader(part));
+    if(!classifier)
+    {
+        return nullptr;
+    }
+
+    lru.push_front(part);
+    Entry &entry=entries[part];
+    entry.classifier=classifier;
+    entry.lru=lru.begin();
+    footprint+=classifier->getFootprint();
+    evict(part);
+    return classifier;
+}
+
+/********************************************************/
+void ModelCache::evict(const string &keep)
+{
+    //the requested network is kept anyway, even if over budget
+    while(budget>0 && footprint>budget && lru.back()!=keep)
+    {
+        auto it=entries.find(lru.back());
+        footprint-=it->second.classifier->getFootprint();
+        entries.erase(it);
+        lru.pop_back();
+    }
+}
+
+/********************************************************/
+bool ModelCache::contains(const string &part) const
+{
+    return (entries.find(part)!=entries.end());
+}
+
+/********************************************************/
+void ModelCache::clear()
+{
+    entries.clear();
+    lru.clear();
+    footprint=0;
+}
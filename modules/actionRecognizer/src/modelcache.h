@@ -0,0 +1,61 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file modelcache.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __MODELCACHE_H__
+#define __MODELCACHE_H__
+
+#include <string>
+#include <list>
+#include <map>
+#include <memory>
+#include <functional>
+#include "classifier.h"
+
+//networks of the different parts, kept loaded within a memory budget;
+//the least recently used ones are dropped first
+class ModelCache
+{
+public:
+    typedef std::function<Classifier*(const std::string&)> Loader;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Classifier> classifier;
+        std::list<std::string>::iterator lru;
+    };
+
+    Loader loader;
+    size_t budget;
+    size_t footprint;
+    std::map<std::string,Entry> entries;
+    std::list<std::string> lru;
+
+    void evict(const std::string &keep);
+
+public:
+    ModelCache();
+
+    //the budget is in bytes, 0 for no limit
+    void configure(const Loader &loader, const size_t budget);
+
+    //loaded if not cached; the classifier stays valid for as long as
+    //it is held, even if evicted meanwhile
+    std::shared_ptr<Classifier> get(const std::string &part);
+
+    bool contains(const std::string &part) const;
+    size_t size() const { return entries.size(); }
+    size_t getFootprint() const { return footprint; }
+    void clear();
+};
+
+#endif
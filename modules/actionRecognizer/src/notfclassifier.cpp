@@ -0,0 +1,20 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file notfclassifier.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include "classifier.h"
+
+/********************************************************/
+//built in place of tfclassifier.cpp when Tensorflow is not available
+Classifier *createTensorflowClassifier(const int, const int)
+{
+    return nullptr;
+}
@@ -0,0 +1,166 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file tfclassifier.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <algorithm>
+#include <tensorflow/core/public/session.h>
+#include <tensorflow/core/protobuf/meta_graph.pb.h>
+#include "classifier.h"
+
+using namespace std;
+using namespace tensorflow;
+
+namespace
+{
+    /********************************************************/
+    class TfClassifier : public Classifier
+    {
+        SessionOptions sess_opts;
+        Session *session;
+        Tensor input;
+        string error;
+        size_t footprint;
+
+        /****************************************************/
+        void release()
+        {
+            if (session != nullptr)
+            {
+                session->Close();
+                delete session;
+                session = nullptr;
+            }
+        }
+
+    public:
+        /****************************************************/
+        TfClassifier(const int intra_op_threads, const int inter_op_threads) :
+            session(nullptr), footprint(0)
+        {
+            sess_opts.config.set_intra_op_parallelism_threads(intra_op_threads);
+            sess_opts.config.set_inter_op_parallelism_threads(inter_op_threads);
+            sess_opts.config.mutable_gpu_options()->set_allow_growth(true); //to limit GPU usage
+        }
+
+        /****************************************************/
+        ~TfClassifier()
+        {
+            release();
+        }
+
+        /****************************************************/
+        bool load(const string &model) override
+        {
+            release();
+            session = NewSession(sess_opts);
+            if (session == nullptr)
+            {
+                error = "Could not create Tensorflow session";
+                return false;
+            }
+
+            // Read in the protobuf graph we exported
+            MetaGraphDef graph_def;
+            string pathToGraph = model + ".meta";
+            Status status = ReadBinaryProto(Env::Default(), pathToGraph, &graph_def);
+            if (!status.ok())
+            {
+                error = "Error reading graph definition from " + pathToGraph + ": " + status.ToString();
+                release();
+                return false;
+            }
+
+            // Add the graph to the session
+            status = session->Create(graph_def.graph_def());
+            if (!status.ok())
+            {
+                error = "Error creating graph: " + status.ToString();
+                release();
+                return false;
+            }
+
+            // Read weights from the saved checkpoint
+            Tensor checkpointPathTensor(DT_STRING, TensorShape());
+            checkpointPathTensor.scalar<std::string>()() = model;
+            status = session->Run(
+                    {{ graph_def.saver_def().filename_tensor_name(), checkpointPathTensor },},
+                    {},
+                    {graph_def.saver_def().restore_op_name()},
+                    nullptr);
+            if (!status.ok())
+            {
+                error = "Error loading checkpoint from " + model + ": " + status.ToString();
+                release();
+                return false;
+            }
+
+            //graph and variables live in the session, the runtime on top
+            //of them is shared by all sessions
+            uint64 size;
+            footprint = 0;
+            if (Env::Default()->GetFileSize(pathToGraph, &size).ok())
+                footprint += size;
+            if (Env::Default()->GetFileSize(model + ".data-00000-of-00001", &size).ok())
+                footprint += size;
+
+            return true;
+        }
+
+        /****************************************************/
+        bool classify(const float *windows, const int n, const int nframes,
+                      const int nfeatures, vector<float> &scores) override
+        {
+            if (session == nullptr)
+            {
+                error = "No network loaded";
+                return false;
+            }
+
+            if (input.dims() != 3 || input.dim_size(0) != n ||
+                input.dim_size(1) != nframes || input.dim_size(2) != nfeatures)
+            {
+                input = Tensor(DT_FLOAT, TensorShape({n,nframes,nfeatures}));
+            }
+            copy(windows, windows+n*nframes*nfeatures, input.flat<float>().data());
+
+            vector<Tensor> outputTensors;
+            Status status = session->Run({{"x:0", input}}, {"add_1:0"}, {}, &outputTensors);
+            if (!status.ok())
+            {
+                error = status.ToString();
+                return false;
+            }
+
+            auto out = outputTensors[0].flat<float>();
+            scores.assign(out.data(), out.data()+out.size());
+            return true;
+        }
+
+        /****************************************************/
+        string getError() const override
+        {
+            return error;
+        }
+
+        /****************************************************/
+        size_t getFootprint() const override
+        {
+            return footprint;
+        }
+    };
+}
+
+/********************************************************/
+Classifier *createTensorflowClassifier(const int intra_op_threads,
+                                       const int inter_op_threads)
+{
+    return new TfClassifier(intra_op_threads, inter_op_threads);
+}
@@ -11,7 +11,9 @@
  */
 
 #include <cstdlib>
+#include <cmath>
 #include <mutex>
+#include <memory>
 #include <algorithm>
 #include <fstream>
 #include <fftw3.h>
@@ -23,6 +25,10 @@
 #include <locale>
 #include "AssistiveRehab/dtw.h"
 #include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/opcClient.h"
+#include "spectrum.h"
+#include "window.h"
+#include "pipeline.h"
 #include "src/feedbackProducer_IDL.h"
 
 using namespace std;
@@ -32,19 +38,39 @@ using namespace yarp::math;
 using namespace iCub::ctrl;
 using namespace assistive_rehab;
 
+/********************************************************/
+//what the analysis of one movement needs, detached from the module
+//state so that it can be carried out while new skeletons come in
+struct Analysis
+{
+    int seq;
+    Bottle label;
+    string metric_tag;
+    vector<string> joint_list;
+    Matrix feedback_thresholds;
+    vector<double> target;
+
+    //either the whole repetition, whose spectra are still to be computed,
+    //or the series of the latest window along with their spectra
+    vector<vector<double>> columns;
+    vector<double> series;
+    vector<int> bins;
+    int nsamples;
+};
+
 /********************************************************/
 class Feedback : public RFModule, public feedbackProducer_IDL
 {
 private:
     //ports
     RpcServer rpcPort;
-    RpcClient opcPort;
+    OpcClient opc;
     RpcClient analyzerPort;
     BufferedPort<Bottle> actionPort;
     BufferedPort<Bottle> outPort;
 
     //parameters
-    int win,filter_order;
+    int win;
     double period;
     bool first;
     bool use_robot_template,mirror_robot_template;
@@ -53,14 +79,32 @@ private:
 
     SkeletonStd skeletonIn,skeletonTemplate;
     string skel_tag,template_tag,metric_tag;
-    vector<vector<Vector>> skeleton_template,skeleton_candidate;
-    bool updated,started;
+    bool updated,template_updated,started;
     vector<string> joint_list;
     Matrix feedback_thresholds;
     double action_threshold;
     vector<double> target;
     Matrix T,T2;
     string part;
+    Spectrum spectrum;
+    mutex spectrum_mtx;
+
+    //keypoints of the analyzed joints, resolved once per configuration,
+    //and their components over the repetition, one column per series
+    vector<const KeyPoint*> keys_template,keys_candidate;
+    vector<vector<double>> columns;
+
+    //analysis over the whole repetition or over the latest samples
+    vector<double> maxpsd,sample;
+    double stream_window,stream_rate,stream_cadence;
+    SlidingWindow window;
+    Bottle prediction;
+    double tlast_feedback;
+
+    //analyses are queued and carried out by a pool of threads
+    Pipeline pipeline;
+    mutex out_mtx;
+    int seq,last_published;
 
 public:
 
@@ -135,6 +179,7 @@ public:
             this->joint_list[i] = joint_list[i];
             yInfo() << this->joint_list[i];
         }
+        mapJoints();
         return true;
     }
 
@@ -146,6 +191,7 @@ public:
         this->use_robot_template = use_robot_template;
         this->mirror_robot_template = mirror_robot_template;
         yInfo() << "Using robot template";
+        mapJoints();
         return true;
     }
 
@@ -155,6 +201,7 @@ public:
         lock_guard<mutex> lg(mtx);
         this->part=part;
         yInfo() << "Analyzing"<<part<<"part";
+        mapJoints();
         return true;
     }
 
@@ -165,6 +212,9 @@ public:
         yInfo() << "Start!";
         started = true;
         first = true;
+        window.clear();
+        prediction.clear();
+        tlast_feedback = Time::now();
         return true;
     }
 
@@ -177,73 +227,56 @@ public:
         template_tag.clear();
         joint_list.clear();
         target.clear();
-        skeleton_template.clear();
-        skeleton_candidate.clear();
+        mapJoints();
+        window.clear();
+        prediction.clear();
+        pipeline.clear();
         started = false;
         return true;
     }
 
     /********************************************************/
-    void getSkeleton()
+    void mapJoints()
     {
-        //ask for the property id
-        Bottle cmd, reply;
-        cmd.addVocab(Vocab::encode("ask"));
-        Bottle &content = cmd.addList().addList();
-        content.addString("skeleton");
-
-        opcPort.write(cmd, reply);
+        //the template may move the opposite side, as in a mirror
+        string side,mirrored;
+        if(mirror_robot_template && !part.empty())
+        {
+            locale loc;
+            side=(toupper(part[0],loc))+part.substr(1,part.size());
+            mirrored=(part=="left"?"Right":"Left");
+        }
 
-        if(reply.size() > 1)
+        keys_template.clear();
+        keys_candidate.clear();
+        for(auto &tag_joint:joint_list)
         {
-            if(reply.get(0).asVocab() == Vocab::encode("ack"))
+            string tag_template=tag_joint;
+            if(mirror_robot_template)
             {
-                if(Bottle *idField = reply.get(1).asList())
-                {
-                    if(Bottle *idValues = idField->get(1).asList())
-                    {
-                        if(!skel_tag.empty())
-                        {
-                            updated=false;
-                            for(int i=0; i<idValues->size(); i++)
-                            {
-                                int id = idValues->get(i).asInt();
-
-                                //given the id, get the value of the property
-                                cmd.clear();
-                                cmd.addVocab(Vocab::encode("get"));
-                                Bottle &content = cmd.addList().addList();
-                                Bottle replyProp;
-                                content.addString("id");
-                                content.addInt(id);
-
-                                opcPort.write(cmd, replyProp);
-                                if(replyProp.get(0).asVocab() == Vocab::encode("ack"))
-                                {
-                                    if(Bottle *propField = replyProp.get(1).asList())
-                                    {
-                                        Property prop(propField->toString().c_str());
-                                        string tag=prop.find("tag").asString();
-                                        if (prop.check("tag") && tag==skel_tag)
-                                        {
-                                            Skeleton* skeleton = skeleton_factory(prop);
-                                            skeletonIn.update(skeleton->toProperty());
-                                            updated = true;
-                                            delete skeleton;
-                                        }
-                                        if(prop.check("tag") && tag==template_tag)
-                                        {
-                                            Skeleton* skeleton = skeleton_factory(prop);
-                                            skeletonTemplate.update(skeleton->toProperty());
-                                            delete skeleton;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+                tag_template=tag_joint.substr(0,tag_joint.find(side))+mirrored;
             }
+
+            keys_template.push_back(skeletonTemplate[tag_template]);
+            keys_candidate.push_back(skeletonIn[tag_joint]);
+            if(keys_template.back()==nullptr || keys_candidate.back()==nullptr)
+            {
+                yWarning() << "Unknown joint" << tag_joint;
+            }
+        }
+
+        columns.assign(2*3*joint_list.size(),vector<double>());
+        window.clear();
+    }
+
+    /********************************************************/
+    void getSkeleton()
+    {
+        if(!skel_tag.empty())
+        {
+            opc.refresh();
+            updated=opc.getSkeleton(skel_tag,skeletonIn);
+            template_updated=opc.getSkeleton(template_tag,skeletonTemplate);
         }
     }
 
@@ -252,18 +285,45 @@ public:
     {
         win = rf.check("win",Value(-1)).asDouble();
         period = rf.check("period",Value(0.01)).asDouble();
-        filter_order = rf.check("filter_order",Value(3)).asInt();
         action_threshold = rf.check("action-threshold",Value(0.3)).asDouble();
+        stream_window = rf.check("stream-window",Value(0.0)).asDouble();
+        stream_rate = rf.check("stream-rate",Value(30.0)).asDouble();
+        stream_cadence = rf.check("stream-cadence",Value(1.0)).asDouble();
+        if(stream_window>0.0)
+        {
+            yInfo() << "Feedback on the latest" << stream_window << "s every" << stream_cadence << "s";
+        }
+        int threads = rf.check("analysis-threads",Value(1)).asInt();
+        int queue = rf.check("analysis-queue",Value(4)).asInt();
+        spectrum.setPeriod(period);
+        spectrum.setPlanner(rf.check("fft-planner",Value("estimate")).asString());
+        if(rf.check("fft-wisdom"))
+        {
+            string wisdom=rf.find("fft-wisdom").asString();
+            if(!spectrum.loadWisdom(wisdom))
+            {
+                yWarning() << "No FFT wisdom imported from" << wisdom;
+            }
+        }
 
-        opcPort.open("/feedbackProducer/opc");
+        if(!opc.open("/feedbackProducer/opc",rf.check("opc-mode",Value("rpc")).asString()))
+        {
+            yError() << "Unable to open the opc client, check opc-mode";
+            return false;
+        }
         outPort.open("/feedbackProducer:o");
         analyzerPort.open("/feedbackProducer/analyzer:rpc");
         actionPort.open("/feedbackProducer/action:i");
         rpcPort.open("/feedbackProducer/rpc");
         attach(rpcPort);
 
+        seq = last_published = 0;
+        pipeline.open(threads,queue);
+
         started = false;
         first = true;
+        updated = template_updated = false;
+        tlast_feedback = 0.0;
         use_robot_template = 0;
         T = T2 = eye(4);
 
@@ -273,7 +333,7 @@ public:
     /********************************************************/
     bool interruptModule() override
     {
-        opcPort.interrupt();
+        opc.interrupt();
         outPort.interrupt();
         analyzerPort.interrupt();
         actionPort.interrupt();
@@ -285,12 +345,15 @@ public:
     /********************************************************/
     bool close() override
     {
-        opcPort.close();
+        //running analyses are completed before the ports go away
+        pipeline.close();
+        opc.close();
         outPort.close();
         analyzerPort.close();
         actionPort.close();
         rpcPort.close();
         yInfo() << "Closed ports";
+        spectrum.saveWisdom();
         return true;
     }
 
@@ -300,45 +363,63 @@ public:
         return period;
     }
 
+    /********************************************************/
+    static void transform(const KeyPoint *k, const Matrix &T, double *out)
+    {
+        //components are interleaved with those of the other skeleton
+        if(k==nullptr)
+        {
+            out[0]=out[2]=out[4]=0.0;
+            return;
+        }
+
+        const Vector &p=k->getPoint();
+        for(int l=0; l<3; l++)
+        {
+            out[2*l]=T(l,0)*p[0]+T(l,1)*p[1]+T(l,2)*p[2]+T(l,3);
+        }
+    }
+
     /********************************************************/
     void updateVec()
     {
-        vector<Vector> temp1,temp2;
-        temp1.clear();
-        temp2.clear();
+        //skeletons are normalized as they come; being the transformations
+        //rigid, only the analyzed joints need to be brought in the common frame
+        Matrix Tt=T*T2;
+        int nseries=2*3*joint_list.size();
+        sample.resize(nseries);
         for(size_t i=0; i<joint_list.size(); i++)
         {
-            string tag_joint=joint_list[i];
-            if(mirror_robot_template)
+            transform(keys_template[i],Tt,&sample[2*3*i]);
+            transform(keys_candidate[i],T,&sample[2*3*i+1]);
+        }
+
+        if(stream_window>0.0)
+        {
+            if(window.getNumSeries()!=nseries)
             {
-                string mirrored_tag_joint;
-                locale loc;
-                string p=(toupper(part[0],loc))+part.substr(1,part.size());
-                size_t found=tag_joint.find(p);
-                if(part=="left")
-                {
-                    mirrored_tag_joint=tag_joint.substr(0,found)+"Right";
-                }
-                else
-                {
-                    mirrored_tag_joint=tag_joint.substr(0,found)+"Left";
-                }
-                temp1.push_back(skeletonTemplate[mirrored_tag_joint]->getPoint());
+                window.resize(nseries,(int)round(stream_window*stream_rate));
             }
-            else
+            window.push(sample.data());
+            if(window.needsResync())
             {
-                temp1.push_back(skeletonTemplate[tag_joint]->getPoint());
+                //plans are shared by the workers
+                lock_guard<mutex> lg(spectrum_mtx);
+                window.resync(spectrum);
+            }
+        }
+        else
+        {
+            for(int s=0; s<nseries; s++)
+            {
+                columns[s].push_back(sample[s]);
             }
-
-            temp2.push_back(skeletonIn[tag_joint]->getPoint());
         }
-
-        skeleton_template.push_back(temp1);
-        skeleton_candidate.push_back(temp2);
     }
 
     /********************************************************/
-    void produceFeedback(const int idx_joint, const vector<int> &freqt, const vector<int> &freqc,
+    void produceFeedback(const Matrix &feedback_thresholds, const int idx_joint,
+                         const vector<int> &freqt, const vector<int> &freqc,
                          const vector<double> &stats, Bottle &feedback)
     {
         double sx_thresh = feedback_thresholds[0][idx_joint];
@@ -458,8 +539,9 @@ public:
     }
 
     /********************************************************/
-    void produceFeedback(const int idx_joint, const Vector &dtemplate2target,
-                         const Vector &dcandidate2target, Bottle &feedback)
+    void produceFeedback(const Matrix &feedback_thresholds, const int idx_joint,
+                         const Vector &dtemplate2target, const Vector &dcandidate2target,
+                         Bottle &feedback)
     {
         int score_thresh = feedback_thresholds[1][idx_joint];
         double inliers_thresh = feedback_thresholds[2][idx_joint];
@@ -490,8 +572,12 @@ public:
     }
 
     /********************************************************/
-    void analyzeRom(Bottle &outfeedback)
+    void analyzeRom(const Analysis &a, Bottle &outfeedback)
     {
+        const vector<string> &joint_list=a.joint_list;
+        const int nsamples=a.nsamples;
+        const double *series=a.series.data();
+        const int *bins=a.bins.data();
         Bottle &f=outfeedback.addList();
         vector<double> joint_template,joint_candidate,warped_template,warped_candidate;
 
@@ -506,41 +592,14 @@ public:
             vector<int> freqt,freqc;
             vector<double> stats;
 
-            Vector xth,yth,zth,xch,ych,zch;
             //for each component (xyz)
             for(int l=0;l<3;l++)
             {
-                //for each sample over time
-                for(int j=0;j<skeleton_template.size();j++)
-                {
-                    joint_template.push_back(skeleton_template[j][i][l]);
-                    joint_candidate.push_back(skeleton_candidate[j][i][l]);
-                }
-
-                if(l%3==0)
-                {
-                    for(int k=0; k<joint_template.size(); k++)
-                    {
-                        xth.push_back(joint_template[k]);
-                        xch.push_back(joint_candidate[k]);
-                    }
-                }
-                if(l%3==1)
-                {
-                    for(int k=0; k<joint_template.size(); k++)
-                    {
-                        yth.push_back(joint_template[k]);
-                        ych.push_back(joint_candidate[k]);
-                    }
-                }
-                if(l%3==2)
-                {
-                    for(int k=0; k<joint_template.size(); k++)
-                    {
-                        zth.push_back(joint_template[k]);
-                        zch.push_back(joint_candidate[k]);
-                    }
-                }
+                //samples over time
+                const double *st=series+(2*(3*i+l))*nsamples;
+                const double *sc=st+nsamples;
+                joint_template.assign(st,st+nsamples);
+                joint_candidate.assign(sc,sc+nsamples);
 
                 /****************/
                 /*     DTW      */
@@ -550,11 +609,8 @@ public:
                 /********************************/
                 /*     Difference in speed      */
                 /********************************/
-                double maxpsdt,maxpsdc;
-                int ft = performFFT(joint_template,maxpsdt);
-                int fc = performFFT(joint_candidate,maxpsdc);
-                freqt.push_back(ft);
-                freqc.push_back(fc);
+                freqt.push_back(bins[2*(3*i+l)]);
+                freqc.push_back(bins[2*(3*i+l)+1]);
 
                 /********************************/
                 /*    Difference in position    */
@@ -571,81 +627,49 @@ public:
                 stats.push_back(sdev);
                 stats.push_back(skwns);
 
-                joint_template.clear();
-                joint_candidate.clear();
                 warped_template.clear();
                 warped_candidate.clear();
             }
 
             //produce feedback for a single joint
             feedbackjoint.addString(tag);
-            produceFeedback(i,freqt,freqc,stats,feedbackjoint);
+            produceFeedback(a.feedback_thresholds,i,freqt,freqc,stats,feedbackjoint);
         }
 
         delete dtw;
     }
 
     /********************************************************/
-    void analyzeEP(Bottle &outfeedback)
+    void analyzeEP(const Analysis &a, Bottle &outfeedback)
     {
-        vector<double> joint_template,joint_candidate;
-        Bottle &f=outfeedback.addList();      
+        const vector<string> &joint_list=a.joint_list;
+        const vector<double> &target=a.target;
+        const int nsamples=a.nsamples;
+        const double *series=a.series.data();
+        Bottle &f=outfeedback.addList();
 
-        Vector xth,yth,zth,xch,ych,zch;
         for(int i=0;i<joint_list.size();i++)
         {
-            double radius = feedback_thresholds[0][i];
+            double radius = a.feedback_thresholds[0][i];
 
             Bottle &feedbackjoint=f.addList();
             string tag=joint_list[i];
 
-            //for each component (xyz)
-            for(int l=0;l<3;l++)
-            {
-                //for each sample over time
-                for(int j=0;j<skeleton_template.size();j++)
-                {
-                    joint_template.push_back(skeleton_template[j][i][l]);
-                    joint_candidate.push_back(skeleton_candidate[j][i][l]);
-                }
-
-                /*******************************************/
-                /*    Difference in reaching the target    */
-                /*******************************************/
-                if(l%3==0)
-                {
-                    for(int k=0; k<joint_template.size(); k++)
-                    {
-                        xth.push_back(joint_template[k]);
-                        xch.push_back(joint_candidate[k]);
-                    }
-                }
-                if(l%3==1)
-                {
-                    for(int k=0; k<joint_template.size(); k++)
-                    {
-                        yth.push_back(joint_template[k]);
-                        ych.push_back(joint_candidate[k]);
-                    }
-                }
-                if(l%3==2)
-                {
-                    for(int k=0; k<joint_template.size(); k++)
-                    {
-                        zth.push_back(joint_template[k]);
-                        zch.push_back(joint_candidate[k]);
-                    }
-                }
-
-                joint_template.clear();
-                joint_candidate.clear();
-            }
+            /*******************************************/
+            /*    Difference in reaching the target    */
+            /*******************************************/
+            const double *xt=series+(2*(3*i))*nsamples;
+            const double *yt=series+(2*(3*i+1))*nsamples;
+            const double *zt=series+(2*(3*i+2))*nsamples;
+            const double *xc=xt+nsamples;
+            const double *yc=yt+nsamples;
+            const double *zc=zt+nsamples;
 
             Vector dist_template2target,dist_candidate2target;
-            for(int k=0; k<xth.size(); k++)
+            for(int k=0; k<nsamples; k++)
             {
-                double dtt = pow(xth[k]-target[0],2)+pow(yth[k]-target[1],2)+pow(zth[k]-target[2],2);
-                double dct = pow(xch[k]-target[0],2)+pow(ych[k]-target[1],2)+pow(zch[k]-target[2],2);
+                double dtt = pow(xt[k]-target[0],2)+pow(yt[k]-target[1],2)+pow(zt[k]-target[2],2);
+                double dct = pow(xc[k]-target[0],2)+pow(yc[k]-target[1],2)+pow(zc[k]-target[2],2);
                 if(dtt < pow(radius,2))
                 {
                     dist_template2target.push_back(dtt);
@@ -655,7 +679,124 @@ public:
 
             //produce feedback for a single joint
             feedbackjoint.addString(tag);
-            produceFeedback(i,dist_template2target,dist_candidate2target,feedbackjoint);
+            produceFeedback(a.feedback_thresholds,i,dist_template2target,
+                            dist_candidate2target,feedbackjoint);
+        }
+    }
+
+    /********************************************************/
+    void analyze(const Analysis &a, Bottle &outfeedback)
+    {
+        const string &metric_tag=a.metric_tag;
+        string exercise = a.label.get(0).asString();
+        string action = a.label.get(1).asString();
+        double confidence = a.label.get(2).asDouble();
+        yInfo() << exercise << action << confidence;
+        if(action == exercise && confidence > action_threshold)
+        {
+            //analysis for ROM
+            if(metric_tag.find("ROM") != std::string::npos)
+            {
+                yInfo() << "Analyzing ROM";
+                analyzeRom(a,outfeedback);
+            }
+
+            //analysis for EP
+            if(metric_tag.find("EP") != std::string::npos)
+            {
+                yInfo() << "Analyzing EP";
+                analyzeEP(a,outfeedback);
+            }
+        }
+        else if(action == "static")
+        {
+            Bottle &bList=outfeedback.addList();
+            Bottle &stat=bList.addList();
+            stat.addString("static");
+        }
+        else if(action == "random")
+        {
+            Bottle &bList=outfeedback.addList();
+            Bottle &random=bList.addList();
+            random.addString("random");
+        }
+        else
+        {
+            Bottle &bList=outfeedback.addList();
+            Bottle &wrong=bList.addList();
+            wrong.addString("wrong");
+        }
+    }
+
+    /********************************************************/
+    void process(Analysis &a)
+    {
+        if(!a.columns.empty())
+        {
+            a.nsamples=a.columns[0].size();
+            yInfo() << a.nsamples << "skeleton samples";
+            yInfo() << a.joint_list.size() << "joints in the skeleton";
+
+            //the spectra of all joints and components, template and
+            //candidate, are computed at once
+            int nseries=a.columns.size();
+            a.series.resize(nseries*a.nsamples);
+            a.bins.resize(nseries);
+            for(int s=0;s<nseries;s++)
+            {
+                copy(a.columns[s].begin(),a.columns[s].end(),a.series.begin()+s*a.nsamples);
+            }
+
+            //plans are shared by the workers
+            vector<double> maxs(nseries);
+            lock_guard<mutex> lg(spectrum_mtx);
+            spectrum.dominantFrequencies(a.series.data(),nseries,a.nsamples,a.bins.data(),maxs.data());
+        }
+
+        Bottle outfeedback;
+        analyze(a,outfeedback);
+        publish(a.seq,outfeedback);
+    }
+
+    /********************************************************/
+    void publish(const int seq, const Bottle &feedback)
+    {
+        lock_guard<mutex> lg(out_mtx);
+
+        //with several workers, a later movement may be done first
+        if(seq<=last_published)
+        {
+            yWarning() << "Dropping outdated feedback";
+            return;
+        }
+        last_published=seq;
+
+        yInfo() << "Sending feedback";
+        Bottle &outfeedback=outPort.prepare();
+        outfeedback=feedback;
+        outPort.write();
+    }
+
+    /********************************************************/
+    shared_ptr<Analysis> makeAnalysis(const Bottle &label)
+    {
+        shared_ptr<Analysis> a(new Analysis);
+        a->seq=++seq;
+        a->label=label;
+        a->metric_tag=metric_tag;
+        a->joint_list=joint_list;
+        a->feedback_thresholds=feedback_thresholds;
+        a->target=target;
+        a->nsamples=0;
+        return a;
+    }
+
+    /********************************************************/
+    void enqueue(const shared_ptr<Analysis> &a)
+    {
+        if(!pipeline.push([this,a]() { process(*a); }))
+        {
+            yWarning() << "Analysis is lagging behind, dropped the oldest movement";
         }
     }
 
@@ -665,7 +806,7 @@ public:
         lock_guard<mutex> lg(mtx);
 
         //if we query the database
-        if(opcPort.getOutputCount() > 0 && started)
+        if(opc.isConnected() && started)
         {
             //get skeleton
             getSkeleton();
@@ -707,13 +848,16 @@ public:
                 first=false;
             }
 
-            skeletonIn.setTransformation(T);
-            skeletonIn.update();
-            skeletonIn.normalize(); //we normalize to avoid differences due to different physiques
-
-            skeletonTemplate.setTransformation(T*T2);
-            skeletonTemplate.update();
-            skeletonTemplate.normalize();
+            //skeletons are normalized once, as they are received, to avoid
+            //differences due to different physiques
+            if(updated)
+            {
+                skeletonIn.normalize();
+            }
+            if(template_updated)
+            {
+                skeletonTemplate.normalize();
+            }
 
             //if the skeleton has been updated
             if(updated)
@@ -721,131 +865,50 @@ public:
                 //update vectors to align
                 updateVec();
 
-                if(Bottle *target=actionPort.read(false))
+                if(stream_window>0.0)
                 {
-                    yInfo() << skeleton_template.size() << "skeleton samples";
-                    yInfo() << skeleton_template[0].size() << "joints in the skeleton";
-                    yInfo() << skeleton_template[0][0].size() << "components for each joint in the skeleton";
-
-                    Bottle &outfeedback=outPort.prepare();
-                    outfeedback.clear();
-
-                    string exercise = target->get(0).asString();
-                    string action = target->get(1).asString();
-                    double confidence = target->get(2).asDouble();
-                    yInfo() << exercise << action << confidence;
-                    if(action == exercise && confidence > action_threshold)
-                    {
-                        //analysis for ROM
-                        if(metric_tag.find("ROM") != std::string::npos)
-                        {
-                            yInfo() << "Analyzing ROM";
-                            analyzeRom(outfeedback);
-                        }
-
-                        //analysis for EP
-                        if(metric_tag.find("EP") != std::string::npos)
-                        {
-                            yInfo() << "Analyzing EP";
-                            analyzeEP(outfeedback);
-                        }
-                    }
-                    else if(action == "static")
+                    //the latest prediction holds until the next one
+                    if(Bottle *target=actionPort.read(false))
                     {
-                        Bottle &bList=outfeedback.addList();
-                        Bottle &stat=bList.addList();
-                        stat.addString("static");
+                        prediction=*target;
                     }
-                    else if(action == "random")
+
+                    double now=Time::now();
+                    if(window.isFull() && (prediction.size()>2) &&
+                       (now-tlast_feedback>=stream_cadence))
                     {
-                        Bottle &bList=outfeedback.addList();
-                        Bottle &random=bList.addList();
-                        random.addString("random");
+                        //the window is copied as it is, the spectra come for free
+                        shared_ptr<Analysis> a=makeAnalysis(prediction);
+                        a->nsamples=window.getCapacity();
+                        int nseries=window.getNumSeries();
+                        a->series.resize(nseries*a->nsamples);
+                        a->bins.resize(nseries);
+                        maxpsd.resize(nseries);
+                        window.copyTo(a->series.data());
+                        window.dominantFrequencies(period*a->nsamples,a->bins.data(),maxpsd.data());
+                        enqueue(a);
+                        tlast_feedback=now;
                     }
-                    else
+                }
+                else if(Bottle *target=actionPort.read(false))
+                {
+                    //the repetition is handed over to the analysis
+                    shared_ptr<Analysis> a=makeAnalysis(*target);
+                    a->columns.swap(columns);
+                    enqueue(a);
+
+                    //the next repetition is likely to last as much
+                    columns.resize(a->columns.size());
+                    for(size_t s=0; s<columns.size(); s++)
                     {
-                        Bottle &bList=outfeedback.addList();
-                        Bottle &wrong=bList.addList();
-                        wrong.addString("wrong");
+                        columns[s].reserve(a->columns[s].size());
                     }
-
-                    yInfo() << "Sending feedback";
-                    outPort.write();
-
-                    skeleton_template.clear();
-                    skeleton_candidate.clear();
                 }
             }
         }
 
         return true;
     }
-
-    /********************************************************/
-    int findMax(const vector<Vector> &p, double &max)
-    {
-        int imax = 1;
-        max = p[imax][0];
-        //consider half of the spectrum
-        for(size_t i=2;i<p.size()/2;i++)
-        {
-            if(p[i][0] > max)
-            {
-                imax = i;
-                max = p[i][0];
-            }
-        }
-
-        if(max == 0)
-            return -1; //joint is stale
-        else
-            return imax;
-    }
-
-    /********************************************************/
-    int
-    performFFT(const vector<double> &s, double &max)
-    {
-        int n = s.size();
-        fftw_complex *in,*out;
-        fftw_plan p;
-
-        in = (fftw_complex*) fftw_malloc(n*sizeof(fftw_complex));
-        out = (fftw_complex*) fftw_malloc(n*sizeof(fftw_complex));
-
-        for(int j=0; j<n; j++)
-        {
-            in[j][0]=s[j];
-            in[j][1]=0.0;
-        }
-
-        //create plan, which is the object containing the parameters required
-        p = fftw_plan_dft_1d(n,in,out,FFTW_FORWARD,FFTW_ESTIMATE);
-
-        //perform FFT
-        fftw_execute(p);
-
-        //compute power spectrum and the frequency content       
-        vector<Vector> psd;
-        vector<Vector> filtered_psd;
-        psd.clear();
-        psd.resize(n);
-        filtered_psd.clear();
-        filtered_psd.resize(n);
-        MedianFilter filter(filter_order,Vector(1,0.0));
-        for(int j=0; j<n; j++)
-        {
-            psd[j].push_back(pow(abs(out[j][0]),2.0) / (1.0/period)*n);
-            filtered_psd[j] = filter.filt(psd[j]);
-        }
-        int f = findMax(psd,max);
-
-        fftw_destroy_plan(p);
-        fftw_free(in);
-        fftw_free(out);
-
-        return f;
-    }
 };
 
 /********************************************************/
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file pipeline.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <algorithm>
+#include "pipeline.h"
+
+using namespace std;
+using namespace yarp::os;
+
+/********************************************************/
+Pipeline::Pipeline() : capacity(1), busy(0), closing(false)
+{
+
+}
+
+/********************************************************/
+Pipeline::~Pipeline()
+{
+    close();
+}
+
+/********************************************************/
+void Pipeline::open(const int nthreads, const int capacity)
+{
+    close();
+    closing=false;
+    this->capacity=(size_t)std::max(capacity,1);
+
+    for(int i=0; i<std::max(nthreads,1); i++)
+    {
+        Worker *worker=new Worker(this);
+        worker->start();
+        workers.push_back(worker);
+    }
+}
+
+/********************************************************/
+void Pipeline::work()
+{
+    unique_lock<mutex> lck(mtx);
+    while(true)
+    {
+        cv_job.wait(lck,[this]() { return closing || !jobs.empty(); });
+        if(closing)
+        {
+            return;
+        }
+
+        function<void()> job=move(jobs.front());
+        jobs.pop_front();
+        busy++;
+        lck.unlock();
+        job();
+        lck.lock();
+        busy--;
+    }
+}
+
+/********************************************************/
+bool Pipeline::push(const function<void()> &job)
+{
+    bool room=true;
+    {
+        lock_guard<mutex> lg(mtx);
+        if(closing)
+        {
+            return false;
+        }
+
+        //the latest data are worth more than the oldest ones
+        if(jobs.size()>=capacity)
+        {
+            jobs.pop_front();
+            room=false;
+        }
+        jobs.push_back(job);
+    }
+    cv_job.notify_one();
+    return room;
+}
+
+/********************************************************/
+void Pipeline::clear()
+{
+    lock_guard<mutex> lg(mtx);
+    jobs.clear();
+}
+
+/********************************************************/
+size_t Pipeline::size()
+{
+    lock_guard<mutex> lg(mtx);
+    return jobs.size()+busy;
+}
+
+/********************************************************/
+void Pipeline::close()
+{
+    {
+        lock_guard<mutex> lg(mtx);
+        closing=true;
+        jobs.clear();
+    }
+    cv_job.notify_all();
+
+    for(auto &worker:workers)
+    {
+        worker->stop();
+        delete worker;
+    }
+    workers.clear();
+}
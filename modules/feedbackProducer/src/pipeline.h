@@ -0,0 +1,63 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file pipeline.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+#include <yarp/os/all.h>
+
+//bounded queue of jobs served by a pool of threads, so that whoever
+//pushes the jobs never waits for them to be done
+class Pipeline
+{
+    class Worker : public yarp::os::Thread
+    {
+        Pipeline *pipeline;
+    public:
+        Worker(Pipeline *pipeline_) : pipeline(pipeline_) { }
+        void run() override { pipeline->work(); }
+    };
+
+    std::mutex mtx;
+    std::condition_variable cv_job;
+    std::deque<std::function<void()>> jobs;
+    size_t capacity;
+    size_t busy;
+    bool closing;
+    std::vector<Worker*> workers;
+
+    void work();
+
+public:
+    Pipeline();
+    ~Pipeline();
+    void open(const int nthreads, const int capacity);
+
+    //false if the oldest pending job had to be dropped to make room
+    bool push(const std::function<void()> &job);
+
+    //pending jobs are dropped, running ones are completed
+    void clear();
+
+    //jobs either pending or running
+    size_t size();
+
+    void close();
+};
+
+#endif
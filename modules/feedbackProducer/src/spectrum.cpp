@@ -0,0 +1,170 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file spectrum.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <algorithm>
+#include "spectrum.h"
+
+using namespace std;
+
+/********************************************************/
+Spectrum::Spectrum() : max_plans(32), flags(FFTW_ESTIMATE), period(0.01)
+{
+
+}
+
+/********************************************************/
+Spectrum::~Spectrum()
+{
+    release();
+}
+
+/********************************************************/
+void Spectrum::release()
+{
+    for(auto &it:plans)
+    {
+        fftw_destroy_plan(it.second.plan);
+        fftw_free(it.second.in);
+        fftw_free(it.second.out);
+    }
+    plans.clear();
+}
+
+/********************************************************/
+void Spectrum::setPlanner(const string &planner)
+{
+    flags=(planner=="measure"?FFTW_MEASURE:FFTW_ESTIMATE);
+}
+
+/********************************************************/
+bool Spectrum::loadWisdom(const string &file)
+{
+    wisdom=file;
+    if(wisdom.empty())
+    {
+        return false;
+    }
+    return (fftw_import_wisdom_from_filename(wisdom.c_str())!=0);
+}
+
+/********************************************************/
+bool Spectrum::saveWisdom()
+{
+    if(wisdom.empty())
+    {
+        return false;
+    }
+    return (fftw_export_wisdom_to_filename(wisdom.c_str())!=0);
+}
+
+/********************************************************/
+Spectrum::Plan &Spectrum::getPlan(const int n, const int nseries)
+{
+    pair<int,int> key(n,nseries);
+    auto it=plans.find(key);
+    if(it!=plans.end())
+    {
+        return it->second;
+    }
+
+    //the length depends on the duration of the movement, hence
+    //plans are dropped all together once there are too many
+    if(plans.size()>=max_plans)
+    {
+        release();
+    }
+
+    //planning may overwrite the buffers, which are filled afterwards
+    int m=n/2+1;
+    Plan p;
+    p.in=fftw_alloc_real((size_t)n*nseries);
+    p.out=fftw_alloc_complex((size_t)m*nseries);
+    p.plan=fftw_plan_many_dft_r2c(1,&n,nseries,p.in,NULL,1,n,
+                                  p.out,NULL,1,m,flags);
+    return (plans[key]=p);
+}
+
+/********************************************************/
+const fftw_complex *Spectrum::transform(const double *data, const int nseries, const int n)
+{
+    Plan &p=getPlan(n,nseries);
+    copy(data,data+(size_t)n*nseries,p.in);
+    fftw_execute(p.plan);
+    return p.out;
+}
+
+/********************************************************/
+void Spectrum::dominantFrequencies(const double *data, const int nseries, const int n,
+                                   int *bins, double *maxs)
+{
+    if(nseries<=0)
+    {
+        return;
+    }
+    if(n<2)
+    {
+        fill(bins,bins+nseries,-1);
+        fill(maxs,maxs+nseries,0.0);
+        return;
+    }
+
+    const fftw_complex *out=transform(data,nseries,n);
+
+    //consider half of the spectrum, skipping the DC
+    int m=n/2+1;
+    int last=std::max(n/2,2);
+    double scale=period*n;
+    psd.resize(last);
+    for(int i=0; i<nseries; i++)
+    {
+        //the power is given by the real part only
+        const fftw_complex *o=out+(size_t)i*m;
+        for(int k=1; k<last; k++)
+        {
+            psd[k]=o[k][0]*o[k][0];
+        }
+
+        double maxv;
+        bins[i]=findMax(psd.data(),last,maxv);
+        maxs[i]=scale*maxv;
+    }
+}
+
+/********************************************************/
+int Spectrum::findMax(const double *psd, const int last, double &max)
+{
+    //branchless reduction, then the first bin reaching it
+    max=psd[1];
+    for(int k=2; k<last; k++)
+    {
+        max=(psd[k]>max?psd[k]:max);
+    }
+    int imax=1;
+    for(int k=1; k<last; k++)
+    {
+        if(psd[k]==max)
+        {
+            imax=k;
+            break;
+        }
+    }
+
+    return (max==0.0?-1:imax); //-1 if the joint is stale
+}
+
+/********************************************************/
+int Spectrum::dominantFrequency(const vector<double> &s, double &max)
+{
+    int bin;
+    dominantFrequencies(s.data(),1,(int)s.size(),&bin,&max);
+    return bin;
+}
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file spectrum.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __SPECTRUM_H__
+#define __SPECTRUM_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <fftw3.h>
+
+//dominant frequency of real signals, through r2c transforms whose plans
+//and aligned buffers are kept across analyses of the same size
+class Spectrum
+{
+    struct Plan
+    {
+        double *in;
+        fftw_complex *out;
+        fftw_plan plan;
+    };
+
+    //keyed by (length of the signals, number of signals)
+    std::map<std::pair<int,int>,Plan> plans;
+    size_t max_plans;
+    unsigned int flags;
+    double period;
+    std::string wisdom;
+    std::vector<double> psd;
+
+    Plan &getPlan(const int n, const int nseries);
+    void release();
+
+public:
+    Spectrum();
+    ~Spectrum();
+
+    //scale of the power spectrum, as the module period
+    void setPeriod(const double period) { this->period=period; }
+
+    //estimate (cheap planning) or measure (faster transforms once planned)
+    void setPlanner(const std::string &planner);
+
+    //plans are imported from and exported to this file, if not empty
+    bool loadWisdom(const std::string &file);
+    bool saveWisdom();
+
+    //r2c transforms of nseries signals of length n stored one after the
+    //other in data, n/2+1 bins each; the output is kept until the next call
+    const fftw_complex *transform(const double *data, const int nseries, const int n);
+
+    //nseries signals of length n stored one after the other in data;
+    //bins[i] is the bin with maximum power in the lower half of the
+    //spectrum, -1 if the signal is stale
+    void dominantFrequencies(const double *data, const int nseries, const int n,
+                             int *bins, double *maxs);
+
+    int dominantFrequency(const std::vector<double> &s, double &max);
+
+    //first bin with maximum power in [1,last), -1 if there is no power
+    static int findMax(const double *psd, const int last, double &max);
+};
+
+#endif
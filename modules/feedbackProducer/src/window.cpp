@@ -0,0 +1,143 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file window.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "spectrum.h"
+#include "window.h"
+
+using namespace std;
+
+/********************************************************/
+SlidingWindow::SlidingWindow() : nseries(0), capacity(0), nbins(0),
+    head(0), count(0), since_resync(0)
+{
+
+}
+
+/********************************************************/
+void SlidingWindow::resize(const int nseries, const int capacity)
+{
+    this->nseries=nseries;
+    this->capacity=std::max(capacity,2);
+
+    //as for the whole signals, half of the spectrum is considered
+    nbins=std::max(this->capacity/2,2);
+    samples.assign(nseries*this->capacity,0.0);
+    re.assign(nseries*nbins,0.0);
+    im.assign(nseries*nbins,0.0);
+    psd.assign(nbins,0.0);
+
+    wre.resize(nbins);
+    wim.resize(nbins);
+    for(int j=0; j<nbins; j++)
+    {
+        wre[j]=cos(2.0*M_PI*j/this->capacity);
+        wim[j]=sin(2.0*M_PI*j/this->capacity);
+    }
+    clear();
+}
+
+/********************************************************/
+void SlidingWindow::clear()
+{
+    fill(samples.begin(),samples.end(),0.0);
+    fill(re.begin(),re.end(),0.0);
+    fill(im.begin(),im.end(),0.0);
+    head=count=since_resync=0;
+}
+
+/********************************************************/
+void SlidingWindow::push(const double *x)
+{
+    if(capacity==0)
+    {
+        return;
+    }
+
+    for(int s=0; s<nseries; s++)
+    {
+        double &oldest=samples[s*capacity+head];
+        double d=x[s]-oldest;
+        oldest=x[s];
+
+        //X_k <- (X_k + x_new - x_old) e^{j2pik/N}
+        double *r=&re[s*nbins];
+        double *i=&im[s*nbins];
+        for(int k=1; k<nbins; k++)
+        {
+            double a=r[k]+d;
+            double b=i[k];
+            r[k]=a*wre[k]-b*wim[k];
+            i[k]=a*wim[k]+b*wre[k];
+        }
+    }
+
+    head=(head+1)%capacity;
+    count=std::min(count+1,capacity);
+    since_resync++;
+}
+
+/********************************************************/
+void SlidingWindow::resync(Spectrum &spectrum)
+{
+    //with the same conventions of the sliding DFT, the transforms
+    //of the signals from the oldest sample yield the spectra
+    ordered.resize(nseries*capacity);
+    copyTo(ordered.data());
+    const fftw_complex *out=spectrum.transform(ordered.data(),nseries,capacity);
+    int m=capacity/2+1;
+    for(int s=0; s<nseries; s++)
+    {
+        const fftw_complex *o=out+(size_t)s*m;
+        double *r=&re[s*nbins];
+        double *i=&im[s*nbins];
+        for(int k=1; k<nbins; k++)
+        {
+            r[k]=o[k][0];
+            i[k]=o[k][1];
+        }
+    }
+    since_resync=0;
+}
+
+/********************************************************/
+void SlidingWindow::copyTo(double *data) const
+{
+    for(int s=0; s<nseries; s++)
+    {
+        const double *x=&samples[s*capacity];
+        double *y=data+s*capacity;
+        for(int m=0; m<capacity; m++)
+        {
+            y[m]=x[(head+m)%capacity];
+        }
+    }
+}
+
+/********************************************************/
+void SlidingWindow::dominantFrequencies(const double scale, int *bins, double *maxs)
+{
+    for(int s=0; s<nseries; s++)
+    {
+        //the power is given by the real part only
+        const double *r=&re[s*nbins];
+        for(int k=1; k<nbins; k++)
+        {
+            psd[k]=r[k]*r[k];
+        }
+
+        double maxv;
+        bins[s]=Spectrum::findMax(psd.data(),nbins,maxv);
+        maxs[s]=scale*maxv;
+    }
+}
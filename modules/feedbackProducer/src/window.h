@@ -0,0 +1,64 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file window.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __WINDOW_H__
+#define __WINDOW_H__
+
+#include <vector>
+
+class Spectrum;
+
+//last samples of a set of signals, kept in a ring buffer along with
+//their spectrum, which is updated per sample by means of a sliding DFT;
+//both cost and memory do not depend on how many samples were pushed
+class SlidingWindow
+{
+    int nseries;
+    int capacity;
+    int nbins;
+    int head,count;
+    int since_resync;
+
+    //one ring per signal, one spectrum per signal
+    std::vector<double> samples;
+    std::vector<double> re,im;
+    std::vector<double> wre,wim;
+    std::vector<double> psd;
+    std::vector<double> ordered;
+
+public:
+    SlidingWindow();
+
+    void resize(const int nseries, const int capacity);
+    void clear();
+
+    int getNumSeries() const { return nseries; }
+    int getCapacity() const { return capacity; }
+    int size() const { return count; }
+    bool isFull() const { return (capacity>0) && (count==capacity); }
+
+    //one sample per signal
+    void push(const double *x);
+
+    //rounding errors would pile up over long sessions, hence the spectra
+    //are to be recomputed from scratch once per window
+    bool needsResync() const { return (capacity>0) && (since_resync>=capacity); }
+    void resync(Spectrum &spectrum);
+
+    //signals from the oldest to the latest sample, one after the other
+    void copyTo(double *data) const;
+
+    //as Spectrum::dominantFrequencies over the whole window
+    void dominantFrequencies(const double scale, int *bins, double *maxs);
+};
+
+#endif
@@ -36,6 +36,7 @@ protected:
     std::string name;
     std::string type;
     std::vector<const Metric*> metrics;
+    std::vector<std::string> joint_list;
     yarp::sig::Matrix feedbackMat;
     yarp::os::Property feedparams;
 
@@ -53,11 +54,12 @@ public:
 
     virtual void setFeedbackParams(const yarp::os::Property &p) = 0;
     yarp::os::Property getFeedbackParams() const { return feedparams; }
+    const std::vector<std::string>& getJointList() const { return joint_list; }
     virtual yarp::sig::Matrix getFeedbackThresholds() = 0;
 
     void print(std::ostream &os=std::cout);
 
-    ~Exercise();
+    virtual ~Exercise();
 
 };
 
@@ -66,7 +68,6 @@ class RangeOfMotion : public Exercise
 private:
     int duration;
     double twarp;
-    std::vector<std::string> joint_list;
     yarp::sig::Vector sx_thresh;
     yarp::sig::Vector sy_thresh;
     yarp::sig::Vector sz_thresh;
@@ -147,7 +148,6 @@ class ReachingLeft : public Exercise
 private:
     int duration;
     double twarp;
-    std::vector<std::string> joint_list;
     yarp::sig::Vector radius,inliers_thresh,zscore_thresh;
 
 public:
@@ -14,6 +14,7 @@
 #define __MANAGER_H__
 
 #include <mutex>
+#include <memory>
 #include <fstream>
 #include <list>
 
@@ -22,11 +23,17 @@
 #include <yarp/sig/Matrix.h>
 
 #include <AssistiveRehab/skeleton.h>
+#include <AssistiveRehab/opcClient.h>
 
 #include "Manager.h"
 #include "Processor.h"
 #include "Metric.h"
 #include "Exercise.h"
+#include "Repertoire.h"
+#include "Recorder.h"
+#include "Patient.h"
+#include "ProcessorPool.h"
+#include "ResultEnvelope.h"
 #include "src/motionAnalyzer_IDL.h"
 
 #include "matio.h"
@@ -35,29 +42,35 @@ class Manager : public yarp::os::RFModule,
                 public motionAnalyzer_IDL
 {
 
-    yarp::os::RpcClient opcPort;
+    assistive_rehab::OpcClient opc;
+    Recorder recorder;
     yarp::os::RpcServer rpcPort;
     yarp::os::RpcClient scalerPort;
     yarp::os::RpcClient dtwPort;
     yarp::os::RpcClient actionPort;
     yarp::os::BufferedPort<yarp::os::Bottle> scopePort;
+    yarp::os::BufferedPort<yarp::os::Bottle> resultsPort;
 
     yarp::os::ResourceFinder *rf;
 
-    std::map<std::string,Exercise*> motion_repertoire;
+    //the current exercise keeps its repertoire alive across reloads
+    std::shared_ptr<Repertoire> repertoire,curr_repertoire;
 
-    std::vector< std::vector <std::pair<std::string,yarp::sig::Vector>> > all_keypoints;
-    std::vector<double> time_samples;
     std::vector<yarp::sig::Vector > all_planes;
     assistive_rehab::SkeletonStd skeletonIn;
 
     yarp::sig::Vector cameraposinit;
     yarp::sig::Vector focalpointinit;
 
-    std::vector<Exercise*> exercises;
     Exercise* curr_exercise;
     std::vector<Processor*> processors;
     const Metric* curr_metric;
+    std::map<std::string,Patient*> patients;
+    ProcessorPool pool;
+    ResultEnvelope envelope;
+    int decimation,nframes_decimated;
+    int scope_slot;
+    bool scope_envelope;
 
     double tstart;
     double tstart_session;
@@ -72,20 +85,44 @@ class Manager : public yarp::os::RFModule,
     int nsession;
     std::string out_folder;
     bool updated;
+    bool initialized;
     std::string prop_tag;
     std::mutex mtx;
+
+    //derived quantities read by query rpcs without waiting for the update:
+    //the configuration is rebuilt only by the rpcs changing it
+    struct Config
+    {
+        std::vector<double> line_pose;
+        std::string exercise,metric_prop;
+        std::vector<std::string> metrics,metric_props,joints,skels,results;
+    };
+    std::shared_ptr<const Config> config;
+
+    //while the motion is copied in place at every update
+    struct Motion
+    {
+        double shoulder_center_height_vel=0.0;
+        yarp::sig::Vector foot_left,foot_right;
+    };
+    Motion motion;
+    std::mutex mtx_motion;
     yarp::sig::Vector shoulder_height;
-    iCub::ctrl::AWLinEstimator *lin_est_shoulder;
+    assistive_rehab::DerivativeEstimator *lin_est_shoulder;
     double shoulder_center_height_vel;
     std::vector<double> line_pose;
     yarp::sig::Matrix world_frame;
 
-    bool loadMotionList(yarp::os::ResourceFinder &rf);
     bool loadExercise(const std::string &exercise_tag) override;
     std::vector<std::string> listExercises() override;
+    bool reloadRepertoire() override;
     std::vector<std::string> listMetricProps() override;
     std::vector<std::string> listJoints() override;
     bool selectSkel(const std::string &skel_tag) override;
+    bool addSkel(const std::string &skel_tag) override;
+    bool removeSkel(const std::string &skel_tag) override;
+    std::vector<std::string> listSkels() override;
+    std::vector<std::string> listResults() override;
     bool selectMetricProp(const std::string &prop_tag) override;
     bool selectMetric(const std::string &metric_tag) override;
     std::string getCurrMetricProp() override;
@@ -103,13 +140,16 @@ class Manager : public yarp::os::RFModule,
     bool setLinePose(const std::vector<double> &line_pose) override;
     bool freeze() override;
 
-    bool writeStructToMat(const std::string& name, const std::vector< std::vector< std::pair<std::string,yarp::sig::Vector> > >& keypoints_skel, mat_t *matfp);
     bool writeStructToMat(const std::string& name, const Exercise *ex, mat_t *matfp);
     matvar_t * writeStructToMat(const Metric *m);
-    bool writeKeypointsToFile(mat_t *matfp);
-    void print(const std::vector< std::vector< std::pair<std::string,yarp::sig::Vector> > >& keypoints_skel);
 
     void getSkeleton();
+    void processSkeleton();
+    void processPatients();
+    void updateScopeSlot();
+    bool isOpcConnected();
+    void publishConfig();
+    void publishMotion();
     bool attach(yarp::os::RpcServer &source) override;
 
 public:
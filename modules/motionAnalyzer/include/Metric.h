@@ -28,10 +28,15 @@ extern const std::string end_point;
 extern const std::string step;
 } 
 
+//typed counterpart of MetricType, resolved once when the repertoire is parsed
+enum class MetricKind { rom, step, end_point };
+
 class Metric
 {
 protected:
+    MetricKind kind;
     std::string type;
+    std::string name;
     std::vector<std::string> properties;
 
 public:
@@ -41,13 +46,14 @@ public:
     virtual void print(std::ostream &os=std::cout) const = 0;
     virtual yarp::os::Property getParams() const = 0;
     std::vector<std::string> getProperties() const { return properties; }
+    MetricKind getKind() const { return kind; }
+    const std::string& getName() const { return name; }
 
 };
 
 class Rom : public Metric
 {
 private:
-    std::string name;
     std::string tag_joint;
     std::string tag_plane;
     yarp::sig::Vector ref_dir;
@@ -75,7 +81,6 @@ public:
 class Step : public Metric
 {
 private:
-    std::string name;
     yarp::sig::Vector num;
     yarp::sig::Vector den;
     double minv,maxv;
@@ -99,7 +104,6 @@ class EndPoint : public Metric
 {
 
 private:
-    std::string name;
     std::string tag_joint;
     std::string tag_plane;
     yarp::sig::Vector ref_dir;
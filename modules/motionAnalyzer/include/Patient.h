@@ -0,0 +1,56 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Patient.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __PATIENT_H__
+#define __PATIENT_H__
+
+#include <string>
+#include <vector>
+
+#include <yarp/os/all.h>
+#include <AssistiveRehab/skeleton.h>
+#include <AssistiveRehab/opcClient.h>
+
+#include "Processor.h"
+#include "Exercise.h"
+#include "ResultEnvelope.h"
+
+//further skeleton analyzed along with the selected one
+class Patient
+{
+    std::string tag;
+    assistive_rehab::SkeletonStd skeleton;
+    const Exercise *exercise;
+    std::vector<Processor*> processors;
+    bool updated,initialized;
+
+    void release();
+
+public:
+    Patient(const std::string &tag);
+    ~Patient();
+
+    void setExercise(const Exercise *exercise);
+    void update(const assistive_rehab::OpcClient &opc);
+    void init(const SkeletonSnapshot &snapshot);
+    void stale() { updated=false; }
+    void reset() { initialized=false; }
+
+    bool isUpdated() const { return updated; }
+    bool isInitialized() const { return initialized; }
+    const std::string& getTag() const { return tag; }
+    const assistive_rehab::SkeletonStd& getSkeleton() const { return skeleton; }
+    std::vector<Processor*>& getProcessors() { return processors; }
+    ResultEnvelope envelope;
+};
+
+#endif
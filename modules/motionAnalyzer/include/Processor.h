@@ -14,44 +14,57 @@
 #define __PROCESSOR_H__
 
 #include <iostream>
+#include <string>
+#include <vector>
 #include <map>
+#include <deque>
 #include <cmath>
 #include <fstream>
 
 #include <yarp/sig/Matrix.h>
 #include <yarp/math/Math.h>
-#include <iCub/ctrl/adaptWinPolyEstimator.h>
 #include <iCub/ctrl/filters.h>
 
 #include <AssistiveRehab/skeleton.h>
+#include <AssistiveRehab/estimators.h>
 #include "Metric.h"
+#include "Snapshot.h"
 
 class Processor;
 
-Processor* createProcessor(const std::string& metric_type, const Metric *metric_);
+Processor* createProcessor(const Metric *metric_);
 
 class Processor
 {
     yarp::sig::Matrix invT;
 
 protected:
-    assistive_rehab::SkeletonStd curr_skeleton,first_skeleton;
+    SkeletonSnapshot curr_snapshot,first_snapshot;
     yarp::sig::Matrix curr_frame;
     yarp::sig::Vector plane_normal;
     double t0;
 
+    //preallocated result slot, one value per metric property
+    std::vector<std::string> props;
+    std::vector<double> result;
+    void setProperties(const Metric *metric, const size_t n);
+
 public:
     Processor();
     virtual ~Processor() {;}
-    void setInitialConf(assistive_rehab::SkeletonStd &skeleton_, yarp::sig::Matrix &T);
-    void update(assistive_rehab::SkeletonStd& curr_skeleton_);
+    void setInitialConf(const SkeletonSnapshot &snapshot, yarp::sig::Matrix &T);
+    void update(const SkeletonSnapshot &snapshot);
     yarp::sig::Vector projectOnPlane(const yarp::sig::Vector &v,const yarp::sig::Vector &plane);
-    yarp::sig::Vector toCurrFrame(const std::string &tag);
+    yarp::sig::Vector toCurrFrame(const assistive_rehab::Skeleton &skeleton, const std::string &tag);
     void stop();
 
     yarp::sig::Vector getPlaneNormal() const { return plane_normal; }
+    const std::vector<double>& getValues() const { return result; }
+    const std::vector<std::string>& getProperties() const { return props; }
+    int getIndex(const std::string &prop) const;
+    yarp::os::Property getResult() const;
+
     virtual void estimate() = 0;
-    virtual yarp::os::Property getResult() = 0;
     virtual std::string getProcessedMetric() const = 0;
 
 };
@@ -66,18 +79,16 @@ public:
     Rom_Processor();
     Rom_Processor(const Metric *rom_);
     void estimate() override;
-    yarp::os::Property getResult() override;
-    std::string getProcessedMetric() const { return rom->getParams().find("name").asString(); }
+    std::string getProcessedMetric() const { return rom->getName(); }
 
 };
 
 class Step_Processor : public Processor
 {
     Step* step;
-    yarp::sig::Vector feetdist;
-    yarp::sig::Vector feetwidth;
     iCub::ctrl::Filter* filter_dist;
-    iCub::ctrl::Filter* filter_width;
+    std::deque<std::pair<double,double> > window;
+    size_t lookahead;
 
     double steplen,prev_steplen;
     double stepwidth,prev_stepwidth;
@@ -92,11 +103,10 @@ public:
     ~Step_Processor();
 
     void estimate() override;
-    yarp::os::Property getResult() override;
-    std::string getProcessedMetric() const { return step->getParams().find("name").asString(); }
+    std::string getProcessedMetric() const { return step->getName(); }
 
-    std::pair<std::vector<double>,std::vector<int> > findPeaks(const yarp::sig::Vector &d);
-    void estimateSpatialParams(const yarp::sig::Vector &dist, const yarp::sig::Vector &width);
+    bool isPeak() const;
+    void estimateSpatialParams(const double dist, const double width);
     double estimateCadence();
     double estimateSpeed();
 
@@ -107,21 +117,11 @@ public:
     double getSpeed() const { return speed; }
 };
 
-
-class JerkEstimator : public iCub::ctrl::AWPolyEstimator
-{
-protected:
-    virtual double getEsteeme() { return 6.0*coeff[3]; }
-
-public:
-    JerkEstimator(unsigned int _N, const double _D) : iCub::ctrl::AWPolyEstimator(3,_N,_D) { }
-};
-
 class EndPoint_Processor : public Processor
 {
     EndPoint* ep;
-    iCub::ctrl::AWLinEstimator *linEst;
-    JerkEstimator *jerkEst;
+    assistive_rehab::DerivativeEstimator *velEst;
+    assistive_rehab::DerivativeEstimator *jerkEst;
     double ideal_traj;
     double vel,smoothness,est_traj;
     double prev_est_traj,prev_ideal_traj;
@@ -134,8 +134,7 @@ public:
     ~EndPoint_Processor();
 
     void estimate() override;
-    yarp::os::Property getResult() override;
-    std::string getProcessedMetric() const { return ep->getParams().find("name").asString(); }
+    std::string getProcessedMetric() const { return ep->getName(); }
 
     double getVel() { return vel; }
     double getSmoothness() { return smoothness; }
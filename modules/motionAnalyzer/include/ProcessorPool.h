@@ -0,0 +1,50 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file ProcessorPool.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __PROCESSORPOOL_H__
+#define __PROCESSORPOOL_H__
+
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+#include <yarp/os/all.h>
+
+class ProcessorPool
+{
+    class Worker : public yarp::os::Thread
+    {
+        ProcessorPool *pool;
+    public:
+        Worker(ProcessorPool *pool_) : pool(pool_) { }
+        void run() override { pool->work(); }
+    };
+
+    std::mutex mtx;
+    std::condition_variable cv_job,cv_done;
+    std::vector<std::function<void()>> *jobs;
+    size_t next,pending;
+    bool closing;
+    std::vector<Worker*> workers;
+
+    void work();
+
+public:
+    ProcessorPool();
+    ~ProcessorPool();
+    void open(const int nthreads);
+    void run(std::vector<std::function<void()>> &jobs);
+    void close();
+};
+
+#endif
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Recorder.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __RECORDER_H__
+#define __RECORDER_H__
+
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <yarp/os/all.h>
+#include <AssistiveRehab/skeleton.h>
+
+#include <hdf5.h>
+
+class Recorder : public yarp::os::Thread
+{
+    //a session with its columns waiting to be written
+    struct Session
+    {
+        std::string basename;
+        std::vector<std::string> tags;
+        std::vector<double> time;
+        std::vector<std::vector<double>> keypoints;
+        bool finished;
+    };
+
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    //sessions still to be written, the one being recorded at the back
+    std::deque<std::shared_ptr<Session>> sessions;
+    size_t chunk_size;
+    int compression;
+    bool opened,closing;
+
+    //session being written, only touched by the thread
+    std::shared_ptr<Session> current;
+    hid_t file;
+    std::vector<hid_t> datasets;
+    size_t nframes;
+
+    bool create(const Session &session);
+    hid_t createDataset(const std::string &name, const size_t cols);
+    bool append(hid_t dataset, const std::vector<double> &data, const size_t n, const size_t cols);
+    bool readColumn(hid_t dataset, const size_t col, std::vector<double> &data);
+    void writeChunk(const std::vector<double> &time, const std::vector<std::vector<double>> &keypoints);
+    bool exportToMat(const Session &session);
+    void finalize();
+    void release();
+
+    void onStop() override;
+    void run() override;
+
+public:
+    Recorder();
+    void setChunkSize(const size_t chunk_size);
+    bool open(const std::string &basename, const assistive_rehab::Skeleton &skeleton);
+    bool isOpen() const { return opened; }
+    void push(const double t, const assistive_rehab::Skeleton &skeleton);
+    void finish();
+};
+
+#endif
@@ -0,0 +1,43 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Repertoire.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __REPERTOIRE_H__
+#define __REPERTOIRE_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <yarp/os/all.h>
+
+#include "Metric.h"
+#include "Exercise.h"
+
+//exercises and typed metrics parsed once from the motion-repertoire file;
+//a reload builds a new repertoire, hence an instance is never modified
+//after load and it can be read from any thread
+class Repertoire
+{
+    std::map<std::string,Exercise*> exercises;
+
+    Repertoire(const Repertoire&) = delete;
+    Repertoire& operator=(const Repertoire&) = delete;
+
+public:
+    Repertoire();
+    ~Repertoire();
+    bool load(const std::string &context, const std::string &from);
+    Exercise* get(const std::string &exercise_tag) const;
+    std::vector<std::string> list() const;
+};
+
+#endif
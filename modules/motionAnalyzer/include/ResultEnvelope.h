@@ -0,0 +1,42 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file ResultEnvelope.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __RESULTENVELOPE_H__
+#define __RESULTENVELOPE_H__
+
+#include <vector>
+
+#include <yarp/os/all.h>
+
+#include "Processor.h"
+
+//latest values of all the metrics of one skeleton, along with
+//their min and max since the last published record
+class ResultEnvelope
+{
+    std::vector<double> packed;
+    size_t n;
+    bool restart;
+
+public:
+    ResultEnvelope();
+    void update(const std::vector<Processor*> &processors, const bool valid=true);
+    void clear() { restart=true; }
+
+    size_t size() const { return n; }
+    double getLast(const size_t i) const { return packed[i]; }
+    double getMin(const size_t i) const { return packed[n+i]; }
+    double getMax(const size_t i) const { return packed[2*n+i]; }
+    void write(yarp::os::Bottle &b) const;
+};
+
+#endif
@@ -0,0 +1,42 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Snapshot.h
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <memory>
+
+#include <AssistiveRehab/skeleton.h>
+
+//skeleton of the current frame, shared by all processors
+class SkeletonFrame
+{
+    assistive_rehab::SkeletonStd raw;
+    assistive_rehab::SkeletonStd normalized;
+    bool planes;
+
+public:
+    SkeletonFrame(const assistive_rehab::Skeleton &skeleton);
+
+    //keypoints as retrieved, for metrics in metric units
+    const assistive_rehab::SkeletonStd& getRaw() const { return raw; }
+
+    //normalized keypoints, with planes computed on them
+    const assistive_rehab::SkeletonStd& getNormalized() const { return normalized; }
+    bool arePlanesUpdated() const { return planes; }
+};
+
+typedef std::shared_ptr<const SkeletonFrame> SkeletonSnapshot;
+
+SkeletonSnapshot makeSnapshot(const assistive_rehab::Skeleton &skeleton);
+
+#endif
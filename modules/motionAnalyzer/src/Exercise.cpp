@@ -52,11 +52,10 @@ void Exercise::addMetric(const Metric* m)
 
 const Metric* Exercise::getCurrMetric(const std::string &metric_tag) const
 {
-    const Metric* m;
+    const Metric* m=NULL;
     for(int i=0;i<metrics.size();i++)
     {
-        string tag=metrics[i]->getParams().find("name").asString();
-        if(tag==metric_tag)
+        if(metrics[i]->getName()==metric_tag)
         {
             m=metrics[i];
             break;
@@ -70,7 +69,7 @@ vector<string> Exercise::listMetrics() const
     vector<string> m(metrics.size());
     for(int i=0;i<metrics.size();i++)
     {
-        m[i]=metrics[i]->getParams().find("name").asString();
+        m[i]=metrics[i]->getName();
     }
 
     return m;
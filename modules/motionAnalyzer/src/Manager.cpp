@@ -14,6 +14,7 @@
 #include <vector>
 #include <list>
 #include <iomanip>
+#include <algorithm>
 
 #include <yarp/os/all.h>
 #include <yarp/sig/Vector.h>
@@ -34,274 +35,6 @@ using namespace yarp::math;
 using namespace iCub::ctrl;
 using namespace assistive_rehab;
 
-bool Manager::loadMotionList(ResourceFinder &rf)
-{
-    lock_guard<mutex> lg(mtx);
-
-    rf.setVerbose();
-    rf.setDefaultContext(this->rf->getContext().c_str());
-    rf.setDefaultConfigFile(this->rf->find("from").asString().c_str());
-    rf.configure(0,NULL);
-
-    Bottle &bGeneral = rf.findGroup("general");
-    if(!bGeneral.isNull())
-    {
-        if(Bottle *bExercises = bGeneral.find("exercises").asList())
-        {
-            int nexercises = bExercises->size();
-            exercises.resize(nexercises);
-            for(int i=0; i<nexercises; i++)
-            {
-                string ex_tag = bExercises->get(i).asString();
-                Bottle &bExercise = rf.findGroup(ex_tag);
-                if(!bExercise.isNull())
-                {
-                    Bottle &bGeneral=bExercise.findGroup("general");
-                    if(!bGeneral.isNull())
-                    {
-                        string type=bGeneral.find("type").asString();
-                        if(ex_tag==ExerciseTag::abduction_left ||
-                                ex_tag==ExerciseTag::internal_rotation_left ||
-                                ex_tag==ExerciseTag::external_rotation_left)
-                        {
-                            exercises[i]=new RangeOfMotion(ex_tag);
-                        }
-                        if(ex_tag==ExerciseTag::reaching_left)
-                        {
-                            exercises[i]=new ReachingLeft();
-                        }
-                        if(ex_tag==ExerciseTag::tug)
-                        {
-                            exercises[i]=new Tug();
-                        }
-                    }
-
-                    //for each exercise we can evaluate different metrics
-                    //check which metric has to be evaluated for this exercise
-                    Bottle &bMetrics = bExercise.findGroup("metrics");
-                    if(!bMetrics.isNull())
-                    {
-                        Bottle *bMetricTags = bMetrics.find("tag").asList();
-                        Bottle *bMetricNumber = bMetrics.find("nmetrics").asList();
-                        if(!bMetricTags->isNull() && !bMetricNumber->isNull())
-                        {
-                            for(int j=0; j<bMetricTags->size(); j++)
-                            {
-                                string metric_type=bMetricTags->get(j).asString();
-                                int nmetrics=bMetricNumber->get(j).asInt();
-                                for(int k=0; k<nmetrics; k++)
-                                {                                   
-                                    string metric_tag=metric_type+"_"+to_string(k);
-                                    Bottle &bMetricEx=bExercise.findGroup(metric_tag);
-                                    if(!bMetricEx.isNull())
-                                    {
-                                        if(metric_type==MetricType::rom)
-                                        {
-                                            string tag_joint = bMetricEx.find("tag_joint").asString();
-                                            Vector ref_dir(3,0.0);
-                                            if(Bottle *bRefDir = bMetricEx.find("ref_dir").asList())
-                                            {
-                                                ref_dir[0] = bRefDir->get(0).asDouble();
-                                                ref_dir[1] = bRefDir->get(1).asDouble();
-                                                ref_dir[2] = bRefDir->get(2).asDouble();
-                                            }
-                                            string ref_joint=bMetricEx.check("ref_joint", Value("")).asString();;
-                                            string tag_plane=bMetricEx.find("tag_plane").asString();
-                                            double minv=bMetricEx.find("min").asDouble();
-                                            double maxv=bMetricEx.find("max").asDouble();
-
-                                            Metric *rom;
-                                            rom=new Rom(metric_type,metric_tag,tag_joint,tag_plane,ref_dir,ref_joint,minv,maxv);
-                                            exercises[i]->addMetric(rom);
-                                        }                                      
-                                        if(metric_type==MetricType::step)
-                                        {
-                                            Bottle *bNum = bMetricEx.find("num").asList();
-                                            Bottle *bDen = bMetricEx.find("den").asList();
-                                            Vector num(6,0.0),den(6,0.0);
-                                            if(!bNum->isNull() && !bDen->isNull())
-                                            {
-                                                num[0] = bNum->get(0).asDouble();
-                                                num[1] = bNum->get(1).asDouble();
-                                                num[2] = bNum->get(2).asDouble();
-                                                num[3] = bNum->get(3).asDouble();
-                                                num[4] = bNum->get(4).asDouble();
-                                                num[5] = bNum->get(5).asDouble();
-
-                                                den[0] = bDen->get(0).asDouble();
-                                                den[1] = bDen->get(1).asDouble();
-                                                den[2] = bDen->get(2).asDouble();
-                                                den[3] = bDen->get(3).asDouble();
-                                                den[4] = bDen->get(4).asDouble();
-                                                den[5] = bDen->get(5).asDouble();
-                                            }
-                                            double minv=bMetricEx.find("min").asDouble();
-                                            double maxv=bMetricEx.find("max").asDouble();
-                                            Metric *step;
-                                            step=new Step(metric_type,metric_tag,num,den,minv,maxv);
-                                            exercises[i]->addMetric(step);
-                                        }
-                                        if(metric_type==MetricType::end_point)
-                                        {
-                                            string tag_joint=bMetricEx.find("tag_joint").asString();
-                                            Vector ref_dir(3,0.0);
-                                            if(Bottle *bRefDir = bMetricEx.find("ref_dir").asList())
-                                            {
-                                                ref_dir[0] = bRefDir->get(0).asDouble();
-                                                ref_dir[1] = bRefDir->get(1).asDouble();
-                                                ref_dir[2] = bRefDir->get(2).asDouble();
-                                            }
-                                            string tag_plane=bMetricEx.find("tag_plane").asString();
-                                            double minv=bMetricEx.find("min").asDouble();
-                                            double maxv=bMetricEx.find("max").asDouble();
-                                            Vector target(3,0.0);
-                                            if(Bottle *bTarget=bMetricEx.find("target").asList())
-                                            {
-                                                target[0]=bTarget->get(0).asDouble();
-                                                target[1]=bTarget->get(1).asDouble();
-                                                target[2]=bTarget->get(2).asDouble();
-                                            }
-                                            Metric *ep;
-                                            ep=new EndPoint(metric_type,metric_tag,tag_joint,tag_plane,ref_dir,minv,maxv,target);
-                                            exercises[i]->addMetric(ep);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    //each exercise can have a specific feedback
-                    Bottle &bFeedback=bExercise.findGroup("feedback");
-                    if(!bFeedback.isNull())
-                    {
-                        Property feedparams;
-                        if(ex_tag==ExerciseTag::abduction_left ||
-                                ex_tag==ExerciseTag::internal_rotation_left ||
-                                ex_tag==ExerciseTag::external_rotation_left)
-                        {
-                            int duration=bFeedback.find("duration").asInt();
-                            double twarp=bFeedback.find("twarp").asDouble();
-                            vector<string> joint_list;
-                            if(Bottle *bJointList=bFeedback.find("joint_list").asList())
-                            {
-                                for(size_t k=0; k<bJointList->size(); k++)
-                                    joint_list.push_back(bJointList->get(k).asString());
-                            }
-                            Vector sx_thresh;
-                            if(Bottle *bSxThresh=bFeedback.find("sx_thresh").asList())
-                            {
-                                for(size_t k=0; k<bSxThresh->size(); k++)
-                                    sx_thresh.push_back(bSxThresh->get(k).asDouble());
-                            }
-                            Vector sy_thresh;
-                            if(Bottle *bSyThresh=bFeedback.find("sy_thresh").asList())
-                            {
-                                for(size_t k=0; k<bSyThresh->size(); k++)
-                                    sy_thresh.push_back(bSyThresh->get(k).asDouble());
-                            }
-                            Vector sz_thresh;
-                            if(Bottle *bSzThresh=bFeedback.find("sz_thresh").asList())
-                            {
-                                for(size_t k=0; k<bSzThresh->size(); k++)
-                                    sz_thresh.push_back(bSzThresh->get(k).asDouble());
-                            }
-                            Vector range_freq;
-                            if(Bottle *bFreqThresh=bFeedback.find("range_freq").asList())
-                            {
-                                for(size_t k=0; k<bFreqThresh->size(); k++)
-                                    range_freq.push_back(bFreqThresh->get(k).asInt());
-                            }
-                            Vector psd_thresh;
-                            if(Bottle *bPsdThresh=bFeedback.find("psd_thresh").asList())
-                            {
-                                for(size_t k=0; k<bPsdThresh->size(); k++)
-                                    psd_thresh.push_back(bPsdThresh->get(k).asDouble());
-                            }
-
-                            feedparams.clear();
-                            feedparams.put("duration",duration);
-                            feedparams.put("twarp",twarp);
-                            Property &p=feedparams.addGroup("thresh");
-                            Property &pjoint=p.addGroup("joint");
-                            Property &psx=p.addGroup("sx");
-                            Property &psy=p.addGroup("sy");
-                            Property &psz=p.addGroup("sz");
-                            Property &freq=p.addGroup("freq");
-                            Property &psd=p.addGroup("psd");
-                            for(int i=0;i<joint_list.size();i++)
-                            {
-                                pjoint.put("joint_"+to_string(i),joint_list[i]);
-                                psx.put("sx_thresh_"+to_string(i),sx_thresh[i]);
-                                psy.put("sy_thresh_"+to_string(i),sy_thresh[i]);
-                                psz.put("sz_thresh_"+to_string(i),sz_thresh[i]);
-                                freq.put("range_freq_"+to_string(i),range_freq[i]);
-                                psd.put("psd_thresh_"+to_string(i),psd_thresh[i]);
-                            }
-                        }
-                        if(ex_tag==ExerciseTag::reaching_left)
-                        {
-                            int duration=bFeedback.find("duration").asInt();
-                            double twarp=bFeedback.find("twarp").asDouble();
-                            vector<string> joint_list;
-                            if(Bottle *bJointList=bFeedback.find("joint_list").asList())
-                            {
-                                for(size_t k=0; k<bJointList->size(); k++)
-                                    joint_list.push_back(bJointList->get(k).asString());
-                            }
-                            Vector radius;
-                            if(Bottle *bRadius=bFeedback.find("radius").asList())
-                            {
-                                for(size_t k=0; k<bRadius->size(); k++)
-                                    radius.push_back(bRadius->get(k).asDouble());
-                            }
-                            Vector zscore;
-                            if(Bottle *bZscore=bFeedback.find("zscore_thresh").asList())
-                            {
-                                for(size_t k=0; k<bZscore->size(); k++)
-                                    zscore.push_back(bZscore->get(k).asDouble());
-                            }
-                            Vector inliers;
-                            if(Bottle *bInliersThresh=bFeedback.find("inliers_thresh").asList())
-                            {
-                                for(size_t k=0; k<bInliersThresh->size(); k++)
-                                    inliers.push_back(bInliersThresh->get(k).asDouble());
-                            }
-
-                            feedparams.clear();
-                            feedparams.put("duration",duration);
-                            feedparams.put("twarp",twarp);
-                            Property &p=feedparams.addGroup("thresh");
-                            Property &pjoint=p.addGroup("joint");
-                            Property &pr=p.addGroup("radius");
-                            Property &pscore=p.addGroup("zscore_thresh");
-                            Property &pinliers=p.addGroup("inliers_thresh");
-                            for(int i=0;i<joint_list.size();i++)
-                            {
-                                pjoint.put("joint_"+to_string(i),joint_list[i]);
-                                pr.put("radius_"+to_string(i),radius[i]);
-                                pscore.put("zscore_thresh_"+to_string(i),zscore[i]);
-                                pinliers.put("inliers_thresh_"+to_string(i),inliers[i]);
-                            }
-                        }
-                        exercises[i]->setFeedbackParams(feedparams);
-                    }
-                    //add the exercise to the repertoire
-                    motion_repertoire.insert(pair<string,Exercise*>(ex_tag,exercises[i]));
-                    motion_repertoire[ex_tag]->print();
-                }
-            }
-        }
-    }
-    else
-    {
-        yError() << "Error in loading parameters. Stopping module!";
-        return false;
-    }
-
-    return true;
-}
-
 /********************************************************/
 bool Manager::setTemplateTag(const string &template_tag)
 {
@@ -326,17 +59,35 @@ bool Manager::setTemplateTag(const string &template_tag)
 bool Manager::loadExercise(const string &exercise_tag)
 {
     lock_guard<mutex> lg(mtx);
-    if(motion_repertoire.count(exercise_tag))
+    if(Exercise *exercise=repertoire->get(exercise_tag))
     {
-        curr_exercise=motion_repertoire.at(exercise_tag);
+        curr_exercise=exercise;
         yInfo()<<"Exercise to perform"<<curr_exercise->getName();
         vector<const Metric*> metrics=curr_exercise->getMetrics();
+        for(size_t i=0; i<processors.size(); i++)
+        {
+            delete processors[i];
+        }
         processors.resize(metrics.size());
-        for(int i=0; i<metrics.size(); i++)
+        for(size_t i=0; i<metrics.size(); i++)
+        {
+            processors[i]=createProcessor(metrics[i]);
+        }
+        //switching in the middle of a session, the new processors take
+        //the next pose as reference, as further skeletons do
+        initialized=false;
+        for(auto &it:patients)
+        {
+            it.second->setExercise(curr_exercise);
+        }
+        //nothing may point into the previous repertoire once it is released
+        if(curr_metric!=NULL)
         {
-            string metric_tag=metrics[i]->getParams().find("name").asString();
-            processors[i]=createProcessor(metric_tag,metrics[i]);
+            curr_metric=curr_exercise->getCurrMetric(curr_metric->getName());
         }
+        curr_repertoire=repertoire;
+        updateScopeSlot();
+        publishConfig();
         if(curr_exercise->getType()==ExerciseType::rehabilitation)
         {
             Bottle cmd,reply;
@@ -363,16 +114,11 @@ bool Manager::loadExercise(const string &exercise_tag)
             cmd.clear();
             reply.clear();
             cmd.addString("setJoints");
-            Property feedparams=curr_exercise->getFeedbackParams();
-            Bottle t=feedparams.findGroup("thresh");
-            Bottle jnt=t.findGroup("joint");
-            vector<string> joint_list;
+            const vector<string> &joint_list=curr_exercise->getJointList();
             Bottle &jl = cmd.addList();
             yInfo()<<"Producing feedback for";
-            for(int i=0;i<jnt.size()-1;i++)
+            for(size_t i=0;i<joint_list.size();i++)
             {
-                Bottle *t1=jnt.get(i+1).asList();
-                joint_list.push_back(t1->get(1).asString());
                 cout<<joint_list[i]<<" ";
                 jl.addString(joint_list[i]);
             }
@@ -398,55 +144,47 @@ bool Manager::loadExercise(const string &exercise_tag)
 /********************************************************/
 string Manager::getExercise()
 {
-    lock_guard<mutex> lg(mtx);
-    if(curr_exercise!=NULL)
-        return curr_exercise->getName();
-    else
-        return "";
-
+    return atomic_load(&config)->exercise;
 }
 
 /********************************************************/
 vector<string> Manager::listExercises()
 {
-    lock_guard<mutex> lg(mtx);
-    vector<string> reply;
-    for (auto it=motion_repertoire.begin(); it!=motion_repertoire.end(); it++)
+    //a reload swaps the whole repertoire
+    return atomic_load(&repertoire)->list();
+}
+
+/********************************************************/
+bool Manager::reloadRepertoire()
+{
+    //parsing does not hold up the analysis
+    shared_ptr<Repertoire> r=make_shared<Repertoire>();
+    if(!r->load(rf->getContext(),rf->find("from").asString()))
     {
-        reply.push_back(it->first);
+        yError() << "Keeping the current motion repertoire";
+        return false;
     }
 
-    return reply;
+    lock_guard<mutex> lg(mtx);
+    atomic_store(&repertoire,r);
+    if(curr_exercise!=NULL)
+    {
+        yInfo() << "The new definition of" << curr_exercise->getName()
+                << "applies from the next loadExercise";
+    }
+    return true;
 }
 
 /********************************************************/
 vector<string> Manager::listMetricProps()
 {
-    lock_guard<mutex> lg(mtx);
-    if(curr_metric!=NULL)
-        return curr_metric->getProperties();
-    else
-        return vector<string>();
+    return atomic_load(&config)->metric_props;
 }
 
 /********************************************************/
 vector<string> Manager::listJoints()
 {
-    lock_guard<mutex> lg(mtx);
-    vector<string> reply;
-    if(curr_exercise!=NULL && curr_exercise->getType()==ExerciseType::rehabilitation)
-    {
-        Property feedparams=curr_exercise->getFeedbackParams();
-        Bottle t=feedparams.findGroup("thresh");
-        Bottle jnt=t.findGroup("joint");
-        for(int i=0;i<jnt.size()-1;i++)
-        {
-            Bottle *t1=jnt.get(i+1).asList();
-            reply.push_back(t1->get(1).asString());
-        }
-    }
-
-    return reply;
+    return atomic_load(&config)->joints;
 }
 
 /********************************************************/
@@ -455,7 +193,9 @@ bool Manager::selectSkel(const string &skel_tag)
     lock_guard<mutex> lg(mtx);
 
     this->skel_tag=skel_tag;
+    initialized=false;
     yInfo() << "Analyzing skeleton " << this->skel_tag.c_str();
+    publishConfig();
 
     if(curr_exercise->getType()==ExerciseType::rehabilitation)
     {
@@ -494,6 +234,59 @@ bool Manager::selectSkel(const string &skel_tag)
     return true;
 }
 
+/********************************************************/
+bool Manager::addSkel(const string &skel_tag)
+{
+    lock_guard<mutex> lg(mtx);
+    if(curr_exercise==NULL)
+    {
+        yWarning()<<"You need to select an exercise first";
+        return false;
+    }
+    if(skel_tag.empty() || skel_tag==this->skel_tag || patients.count(skel_tag))
+    {
+        yWarning()<<"Skeleton"<<skel_tag<<"is already analyzed";
+        return false;
+    }
+
+    Patient *patient=new Patient(skel_tag);
+    patient->setExercise(curr_exercise);
+    patients[skel_tag]=patient;
+    yInfo()<<"Analyzing also skeleton"<<skel_tag;
+    publishConfig();
+    return true;
+}
+
+/********************************************************/
+bool Manager::removeSkel(const string &skel_tag)
+{
+    lock_guard<mutex> lg(mtx);
+    auto it=patients.find(skel_tag);
+    if(it==patients.end())
+    {
+        yWarning()<<"Skeleton"<<skel_tag<<"is not analyzed";
+        return false;
+    }
+
+    delete it->second;
+    patients.erase(it);
+    yInfo()<<"Not analyzing skeleton"<<skel_tag<<"anymore";
+    publishConfig();
+    return true;
+}
+
+/********************************************************/
+vector<string> Manager::listSkels()
+{
+    return atomic_load(&config)->skels;
+}
+
+/********************************************************/
+vector<string> Manager::listResults()
+{
+    return atomic_load(&config)->results;
+}
+
 /********************************************************/
 bool Manager::setPart(const string &part)
 {
@@ -541,6 +334,8 @@ bool Manager::selectMetricProp(const string &prop_tag)
     {
         this->prop_tag=prop_tag;
         yInfo()<<"Visualizing property"<<this->prop_tag;
+        updateScopeSlot();
+        publishConfig();
         return true;
     }
     else
@@ -553,23 +348,18 @@ bool Manager::selectMetricProp(const string &prop_tag)
 /********************************************************/
 string Manager::getCurrMetricProp()
 {
-    lock_guard<mutex> lg(mtx);
-    return prop_tag;
+    return atomic_load(&config)->metric_prop;
 }
 
 /********************************************************/
 vector<string> Manager::listMetrics()
 {
-    lock_guard<mutex> lg(mtx);
-    if(curr_exercise!=NULL)
-    {
-        return curr_exercise->listMetrics();
-    }
-    else
+    shared_ptr<const Config> s=atomic_load(&config);
+    if(s->exercise.empty())
     {
         yWarning()<<"You need to select an exercise first";
-        return vector<string>();
     }
+    return s->metrics;
 }
 
 /********************************************************/
@@ -583,6 +373,8 @@ bool Manager::selectMetric(const string &metric_tag)
         vector<string> available_props=curr_metric->getProperties();
         if(available_props.size()>0)
             prop_tag=available_props.back();
+        updateScopeSlot();
+        publishConfig();
 
         if(curr_exercise->getType()==ExerciseType::rehabilitation)
         {
@@ -629,13 +421,18 @@ bool Manager::start(const bool use_robot_template)
 	
     if (!starting)
     {
-        bool out=false;
+        //we do not start if we haven't selected a skeleton tag or added any skeleton
+        if(skel_tag.empty() && patients.empty())
+        {
+            yWarning() << "Please select a proper skeleton tag";
+            return false;
+        }
+
+        bool out=skel_tag.empty();
         while(out==false)
         {
             getSkeleton();
-
-            //we do not start if we haven't selected a skeleton tag
-            if(skel_tag.empty() || !updated)
+            if(!updated)
             {
                 yWarning() << "Please select a proper skeleton tag";
                 return false;
@@ -644,15 +441,32 @@ bool Manager::start(const bool use_robot_template)
             out=skeletonIn.update_planes();
             Time::yield();
         }
+
+        //further skeletons get their reference frame when first seen
+        for(auto &it:patients)
+        {
+            it.second->reset();
+        }
     }
 
     if(curr_exercise->getType()==ExerciseType::rehabilitation)
     {
+        //the feedback is given on the selected skeleton only,
+        //the added ones are just analyzed
+        if(skel_tag.empty())
+        {
+            tstart_session=Time::now()-tstart;
+            starting=true;
+            return true;
+        }
+
         Matrix T;
+        SkeletonSnapshot snapshot=makeSnapshot(skeletonIn);
         for(int i=0; i<processors.size(); i++)
         {
-            processors[i]->setInitialConf(skeletonIn,T);
+            processors[i]->setInitialConf(snapshot,T);
         }
+        initialized=true;
 
         Property params=curr_exercise->getFeedbackParams();
         Bottle cmd,reply;
@@ -823,28 +637,26 @@ bool Manager::stop()
 
         tend_session=Time::now()-tstart;
 
-        // Use MATIO to write the results in a .mat file
+        // Use MATIO to write the exercise in a .mat file,
+        // keypoints are appended by the recorder in background
         string filename_report=out_folder+"/user-"+skeletonIn.getTag()+
                 "-"+curr_exercise->getName()+"-"+to_string(nsession)+".mat";
         mat_t *matfp=Mat_CreateVer(filename_report.c_str(),NULL,MAT_FT_MAT5);
         if (matfp==NULL)
             yError()<<"Error creating MAT file";
-
-        yInfo() << "Writing to file";
-        if(writeKeypointsToFile(matfp))
+        else
         {
-            time_samples.clear();
-            all_keypoints.clear();
+            yInfo() << "Writing to file";
+            if(!writeStructToMat("Exercise",curr_exercise,matfp))
+                yError() << "Could not save exercise";
+            Mat_Close(matfp);
         }
-        else
-            yError() << "Could not save to file";
-
-        yInfo() << "Keypoints saved to file" << filename_report.c_str();
-        Mat_Close(matfp);
+        recorder.finish();
 
         nsession++;
         starting=false;
         skel_tag="";
+        publishConfig();
 
         return true;
     }
@@ -863,25 +675,37 @@ bool Manager::freeze()
 /********************************************************/
 bool Manager::isStanding(const double standing_thresh)
 {
-    lock_guard<mutex> lg(mtx);
-    yInfo()<<"shoulder height speed"<<shoulder_center_height_vel;
-    return (shoulder_center_height_vel>standing_thresh);
+    mtx_motion.lock();
+    double vel=motion.shoulder_center_height_vel;
+    mtx_motion.unlock();
+    yInfo()<<"shoulder height speed"<<vel;
+    return (vel>standing_thresh);
 }
 
 /********************************************************/
 bool Manager::isSitting(const double standing_thresh)
 {
-    lock_guard<mutex> lg(mtx);
-    yInfo()<<"shoulder height speed"<<shoulder_center_height_vel;
-    return (shoulder_center_height_vel<-standing_thresh);
+    mtx_motion.lock();
+    double vel=motion.shoulder_center_height_vel;
+    mtx_motion.unlock();
+    yInfo()<<"shoulder height speed"<<vel;
+    return (vel<-standing_thresh);
 }
 
 /********************************************************/
 bool Manager::hasCrossedFinishLine(const double finishline_thresh)
 {
-    lock_guard<mutex> lg(mtx);
-    Vector foot_right=skeletonIn[KeyPointTag::ankle_right]->getPoint();
-    Vector foot_left=skeletonIn[KeyPointTag::ankle_left]->getPoint();
+    shared_ptr<const Config> s=atomic_load(&config);
+    const vector<double> &line_pose=s->line_pose;
+    mtx_motion.lock();
+    Vector foot_right=motion.foot_right;
+    Vector foot_left=motion.foot_left;
+    mtx_motion.unlock();
+    if(line_pose.size()<7)
+    {
+        yWarning()<<"The pose of the finish line has not been set";
+        return false;
+    }
 
     Vector lp_world(3);
     lp_world[0]=line_pose[0];
@@ -914,84 +738,250 @@ bool Manager::setLinePose(const vector<double> &line_pose)
 {
     lock_guard<mutex> lg(mtx);
     this->line_pose=line_pose;
+    publishConfig();
     return true;
 }
 
 /********************************************************/
 void Manager::getSkeleton()
 {
-    //ask for the property id
-    Bottle cmd,reply;
-    cmd.addVocab(Vocab::encode("ask"));
-    Bottle &content = cmd.addList().addList();
-    content.addString("skeleton");
+    for(auto &it:patients)
+    {
+        it.second->stale();
+    }
 
-//    yInfo() << "Query opc: " << cmd.toString();
-    opcPort.write(cmd, reply);
-//    yInfo() << "Reply from opc:" << reply.toString();
+    updated=false;
+    if(skel_tag.empty() && patients.empty())
+    {
+        return;
+    }
+    opc.refresh();
+    if(!skel_tag.empty() && opc.getSkeleton(skel_tag,skeletonIn))
+    {
+        processSkeleton();
+    }
+    for(auto &it:patients)
+    {
+        it.second->update(opc);
+    }
+}
+
+/********************************************************/
+void Manager::processSkeleton()
+{
+    if(skeletonIn[KeyPointTag::shoulder_center]->isUpdated())
+    {
+        Vector shoulder_center=skeletonIn[KeyPointTag::shoulder_center]->getPoint();
+        lin_est_shoulder->estimate(shoulder_center,Time::now());
+        shoulder_center_height_vel=lin_est_shoulder->getVelocity()[2];
+    }
+    updated=true;
+}
 
-    if(reply.size() > 1)
+/********************************************************/
+void Manager::processPatients()
+{
+    //one job per processor, each patient with its own snapshot
+    vector<function<void()>> jobs;
+    if(updated)
     {
-        if(reply.get(0).asVocab() == Vocab::encode("ack"))
+        SkeletonSnapshot snapshot=makeSnapshot(skeletonIn);
+
+        //a skeleton selected once started takes the first pose seen as reference
+        if(!initialized)
         {
-            if(Bottle *idField = reply.get(1).asList())
+            if(curr_exercise->getType()==ExerciseType::rehabilitation)
             {
-                if(Bottle *idValues = idField->get(1).asList())
+                Matrix T;
+                for(int i=0; i<processors.size(); i++)
                 {
-                    if(!skel_tag.empty())
-                    {
-                        updated=false;
-                        for(int i=0; i<idValues->size(); i++)
-                        {
-                            int id = idValues->get(i).asInt();
-
-                            //given the id, get the value of the property
-                            cmd.clear();
-                            cmd.addVocab(Vocab::encode("get"));
-                            Bottle &content = cmd.addList().addList();
-                            Bottle replyProp;
-                            content.addString("id");
-                            content.addInt(id);
-
-//                            yInfo() << "Command sent to the port: " << cmd.toString();
-                            opcPort.write(cmd, replyProp);
-//                            yInfo() << "Reply from opc:" << replyProp.toString();
-
-                            if(replyProp.get(0).asVocab() == Vocab::encode("ack"))
-                            {
-                                if(Bottle *propField = replyProp.get(1).asList())
-                                {
-                                    Property prop(propField->toString().c_str());
-                                    string tag=prop.find("tag").asString();
-                                    if(!tag.empty())
-                                    {
-                                        if(prop.check("tag") && tag==skel_tag)
-                                        {
-                                            Skeleton* skeleton = skeleton_factory(prop);
-                                            skeletonIn.update(skeleton->toProperty());
-                                            if(skeleton->update_planes())
-                                            {
-                                                vector<pair<string,Vector>> keyps=skeletonIn.get_unordered();
-                                                all_keypoints.push_back(keyps);
-                                            }
-                                            if(skeletonIn[KeyPointTag::shoulder_center]->isUpdated())
-                                            {
-                                                Vector shoulder_center=skeletonIn[KeyPointTag::shoulder_center]->getPoint();
-                                                AWPolyElement el(shoulder_center,Time::now());
-                                                shoulder_center_height_vel=lin_est_shoulder->estimate(el)[2];
-                                            }
-                                            updated=true;
-                                            delete skeleton;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    processors[i]->setInitialConf(snapshot,T);
                 }
             }
+            initialized=true;
+        }
+
+        for(int i=0; i<processors.size(); i++)
+        {
+            Processor *processor=processors[i];
+            jobs.push_back([processor,snapshot]() {
+                processor->update(snapshot);
+                processor->estimate();
+            });
+        }
+    }
+    for(auto &it:patients)
+    {
+        Patient *patient=it.second;
+        if(patient->isUpdated())
+        {
+            SkeletonSnapshot patient_snapshot=makeSnapshot(patient->getSkeleton());
+            if(!patient->isInitialized())
+            {
+                patient->init(patient_snapshot);
+            }
+            for(auto &processor:patient->getProcessors())
+            {
+                jobs.push_back([processor,patient_snapshot]() {
+                    processor->update(patient_snapshot);
+                    processor->estimate();
+                });
+            }
         }
     }
+    if(jobs.empty())
+    {
+        return;
+    }
+    pool.run(jobs);
+
+    //patients not seen yet output zeros so that the layout does not change
+    if(!skel_tag.empty())
+    {
+        envelope.update(processors);
+    }
+    for(auto &it:patients)
+    {
+        it.second->envelope.update(it.second->getProcessors(),it.second->isInitialized());
+    }
+
+    if(++nframes_decimated<decimation)
+    {
+        return;
+    }
+    nframes_decimated=0;
+
+    //write on output ports, the selected skeleton first and then the others by tag
+    vector<ResultEnvelope*> envelopes;
+    if(!skel_tag.empty())
+    {
+        envelopes.push_back(&envelope);
+    }
+    for(auto &it:patients)
+    {
+        envelopes.push_back(&it.second->envelope);
+    }
+
+    if(scope_slot>=0)
+    {
+        Bottle &scopebottleout=scopePort.prepare();
+        scopebottleout.clear();
+        for(auto &env:envelopes)
+        {
+            if((size_t)scope_slot<env->size())
+            {
+                scopebottleout.addDouble(env->getLast(scope_slot));
+                if(scope_envelope)
+                {
+                    scopebottleout.addDouble(env->getMin(scope_slot));
+                    scopebottleout.addDouble(env->getMax(scope_slot));
+                }
+            }
+        }
+        scopePort.write();
+    }
+
+    if(resultsPort.getOutputCount()>0)
+    {
+        shared_ptr<const Config> s=atomic_load(&config);
+        const vector<string> &tags=s->skels;
+        Bottle &results=resultsPort.prepare();
+        results.clear();
+        results.addDouble(Time::now()-tstart);
+        for(size_t i=0; i<envelopes.size() && i<tags.size(); i++)
+        {
+            Bottle &item=results.addList();
+            item.addString(tags[i]);
+            envelopes[i]->write(item);
+        }
+        resultsPort.write();
+    }
+
+    for(auto &env:envelopes)
+    {
+        env->clear();
+    }
+}
+
+/********************************************************/
+void Manager::updateScopeSlot()
+{
+    //flat index of the selected property among all the results
+    scope_slot=-1;
+    if(curr_metric==NULL)
+    {
+        return;
+    }
+
+    string metric_name=curr_metric->getParams().find("name").asString();
+    int offset=0;
+    for(int i=0; i<processors.size(); i++)
+    {
+        if(processors[i]->getProcessedMetric()==metric_name)
+        {
+            int idx=processors[i]->getIndex(prop_tag);
+            if(idx>=0)
+            {
+                scope_slot=offset+idx;
+            }
+            return;
+        }
+        offset+=(int)processors[i]->getValues().size();
+    }
+}
+
+/********************************************************/
+void Manager::publishConfig()
+{
+    //called with mtx held, readers keep the configuration they loaded
+    shared_ptr<Config> s=make_shared<Config>();
+    s->line_pose=line_pose;
+    s->metric_prop=prop_tag;
+    if(curr_exercise!=NULL)
+    {
+        s->exercise=curr_exercise->getName();
+        s->metrics=curr_exercise->listMetrics();
+        if(curr_exercise->getType()==ExerciseType::rehabilitation)
+        {
+            s->joints=curr_exercise->getJointList();
+        }
+    }
+    if(curr_metric!=NULL)
+    {
+        s->metric_props=curr_metric->getProperties();
+    }
+    for(int i=0; i<processors.size(); i++)
+    {
+        for(auto &prop:processors[i]->getProperties())
+        {
+            s->results.push_back(processors[i]->getProcessedMetric()+"::"+prop);
+        }
+    }
+    if(!skel_tag.empty())
+    {
+        s->skels.push_back(skel_tag);
+    }
+    for(auto &it:patients)
+    {
+        s->skels.push_back(it.first);
+    }
+    atomic_store(&config,shared_ptr<const Config>(s));
+}
+
+/********************************************************/
+void Manager::publishMotion()
+{
+    //called with mtx held, the vectors keep their size and are not reallocated
+    lock_guard<mutex> lg(mtx_motion);
+    motion.shoulder_center_height_vel=shoulder_center_height_vel;
+    motion.foot_left=skeletonIn[KeyPointTag::ankle_left]->getPoint();
+    motion.foot_right=skeletonIn[KeyPointTag::ankle_right]->getPoint();
+}
+
+/********************************************************/
+bool Manager::isOpcConnected()
+{
+    return opc.isConnected();
 }
 
 /********************************************************/
@@ -1003,14 +993,34 @@ bool Manager::attach(RpcServer &source)
 /********************************************************/
 bool Manager::configure(ResourceFinder &rf)
 {
+    //query rpcs may come as soon as the port is attached
+    config=make_shared<const Config>();
+
     this->rf = &rf;
     string moduleName = rf.check("name", Value("motionAnalyzer")).asString();
     setName(moduleName.c_str());
 
     string robot = rf.check("robot", Value("icub")).asString();
 
-    opcPort.open(("/" + getName() + "/opc").c_str());
+    if(!opc.open("/" + getName() + "/opc",rf.check("opc-mode", Value("rpc")).asString()))
+    {
+        yError() << "Unable to open the opc client, check opc-mode";
+        return false;
+    }
+    if(opc.isBroadcast())
+    {
+        yInfo() << "Reading skeletons from the opc broadcast";
+    }
+
+    recorder.setChunkSize(rf.check("record-chunk-size", Value(100)).asInt());
+    pool.open(rf.check("threads", Value(4)).asInt());
+    decimation=std::max(rf.check("decimation", Value(1)).asInt(),1);
+    scope_envelope=rf.check("scope-envelope", Value(false)).asBool();
+    nframes_decimated=0;
+    scope_slot=-1;
+
     scopePort.open(("/" + getName() + "/scope").c_str());
+    resultsPort.open(("/" + getName() + "/results:o").c_str());
     scalerPort.open(("/" + getName() + "/scaler:cmd").c_str());
     dtwPort.open(("/" + getName() + "/dtw:cmd").c_str());
     actionPort.open(("/" + getName() + "/action:cmd").c_str());
@@ -1020,8 +1030,12 @@ bool Manager::configure(ResourceFinder &rf)
     cameraposinit.resize(3);
     focalpointinit.resize(3);
 
-    if(!loadMotionList(rf))
+    repertoire=make_shared<Repertoire>();
+    if(!repertoire->load(rf.getContext(),rf.find("from").asString()))
+    {
+        yError() << "Error in loading parameters. Stopping module!";
         return false;
+    }
 
     out_folder=rf.getHomeContextPath();
     tstart=Time::now();
@@ -1032,16 +1046,24 @@ bool Manager::configure(ResourceFinder &rf)
     prop_tag="";
     curr_exercise=NULL;
     curr_metric=NULL;
-    lin_est_shoulder=new AWLinEstimator(16,0.01);
+    lin_est_shoulder=new DerivativeEstimator(3,10,2);
+    shoulder_center_height_vel=0.0;
     frozen=false;
+    initialized=false;
+
+    mtx.lock();
+    publishConfig();
+    publishMotion();
+    mtx.unlock();
     return true;
 }
 
 /********************************************************/
 bool Manager::interruptModule()
 {
-    opcPort.interrupt();
+    opc.interrupt();
     scopePort.interrupt();
+    resultsPort.interrupt();
     scalerPort.interrupt();
     dtwPort.interrupt();
     actionPort.interrupt();
@@ -1054,19 +1076,23 @@ bool Manager::interruptModule()
 /********************************************************/
 bool Manager::close()
 {
-    for(int i=0; i<exercises.size(); i++)
-    {
-        delete exercises[i];
-    }
     for(int i=0; i<processors.size(); i++)
     {
         delete processors[i];
     }
+    for(auto &it:patients)
+    {
+        delete it.second;
+    }
     delete lin_est_shoulder;
     yInfo() << "Freed memory";
 
-    opcPort.close();
+    pool.close();
+    recorder.stop();
+
+    opc.close();
     scopePort.close();
+    resultsPort.close();
     scalerPort.close();
     dtwPort.close();
     actionPort.close();
@@ -1088,10 +1114,14 @@ bool Manager::updateModule()
     lock_guard<mutex> lg(mtx);
 
     //if we query the database
-    if(opcPort.getOutputCount()>0)
+    if(isOpcConnected())
     {
         //get skeleton and normalize
         getSkeleton();
+        if(updated)
+        {
+            publishMotion();
+        }
 
         //if no metric has been defined we do not analyze motion
         if(starting)
@@ -1100,26 +1130,17 @@ bool Manager::updateModule()
             {
                 if(updated)
                 {
-                    //update time array
-                    time_samples.push_back(Time::now()-tstart);
-
-                    //write on output port
-                    Bottle &scopebottleout=scopePort.prepare();
-                    scopebottleout.clear();
-                    for(int i=0; i<processors.size(); i++)
+                    //record the session
+                    if(!recorder.isOpen())
                     {
-                        processors[i]->update(skeletonIn);
-                        processors[i]->estimate();
-                        Property result=processors[i]->getResult();
-                        if(result.check(prop_tag) &&
-                                processors[i]->getProcessedMetric()==curr_metric->getParams().find("name").asString())
-                        {
-                            double res=result.find(prop_tag).asDouble();
-                            scopebottleout.addDouble(res);
-                        }
+                        recorder.open(out_folder+"/user-"+skeletonIn.getTag()+"-"+
+                                      curr_exercise->getName()+"-"+to_string(nsession),skeletonIn);
                     }
-                    scopePort.write();
+                    recorder.push(Time::now()-tstart,skeletonIn);
                 }
+
+                //each skeleton is processed as soon as it is updated, regardless of the others
+                processPatients();
             }
             else
                 yInfo() << "Please specify metric";
@@ -1129,55 +1150,6 @@ bool Manager::updateModule()
     return true;
 }
 
-/********************************************************/
-bool Manager::writeStructToMat(const string& name, const vector< vector< pair<string,Vector> > >& keypoints_skel, mat_t *matfp)
-{
-    int numKeypoints = skeletonIn.getNumKeyPoints();
-    const char *fields[numKeypoints];
-    for(int i=0; i<numKeypoints; i++)
-    {
-        fields[i]=keypoints_skel[0][i].first.c_str();
-    }
-
-    matvar_t *field;
-
-    size_t dim_struct[2] = {1,1};
-
-    size_t nSamples = keypoints_skel.size()-1;
-
-    matvar_t *matvar = Mat_VarCreateStruct(name.c_str(),2,dim_struct,fields,numKeypoints);
-    if(matvar != NULL)
-    {
-        vector<double> field_vector;
-        field_vector.resize(3*(nSamples));
-
-        size_t dims_field[2] = {nSamples,3};
-
-    //    print(keypoints_skel);
-
-        for(int i=0; i<numKeypoints; i++)
-        {
-            for(int j=0; j<nSamples; j++)
-            {
-                field_vector[j] = keypoints_skel[j][i].second[0];
-                field_vector[j+nSamples] = keypoints_skel[j][i].second[1];
-                field_vector[j+2*nSamples] = keypoints_skel[j][i].second[2];
-            }
-
-            field = Mat_VarCreate(NULL,MAT_C_DOUBLE,MAT_T_DOUBLE,2,dims_field,field_vector.data(),MAT_F_GLOBAL);
-            Mat_VarSetStructFieldByName(matvar, fields[i], 0, field);
-        }
-
-        Mat_VarWrite(matfp,matvar,MAT_COMPRESSION_NONE);
-        Mat_VarFree(matvar);
-    }
-    else
-        return false;
-
-    return true;
-
-}
-
 /********************************************************/
 bool Manager::writeStructToMat(const string& name, const Exercise* ex, mat_t *matfp)
 {
@@ -1408,57 +1380,3 @@ matvar_t * Manager::writeStructToMat(const Metric* m)
     }
     return submatvar;
 }
-
-/********************************************************/
-void Manager::print(const vector< vector< pair<string,Vector> > >& keypoints_skel)
-{
-    for(int i=0; i<keypoints_skel[0].size(); i++)
-    {
-        for(int j=0; j<keypoints_skel.size(); j++)
-        {
-            cout << keypoints_skel[j][i].first << " " << keypoints_skel[j][i].second[0] << " "
-                 << keypoints_skel[j][i].second[1] << " " << keypoints_skel[j][i].second[2] << endl;
-        }
-    }
-    cout << endl;
-}
-
-/********************************************************/
-bool Manager::writeKeypointsToFile(mat_t *matfp)
-{
-    // Use MATIO to write the results in a .mat file
-
-    //Save time samples
-    size_t nSamples=time_samples.size();
-    size_t dims[2]={nSamples,1};
-    matvar_t *matvar=Mat_VarCreate("Time_samples",MAT_C_DOUBLE,MAT_T_DOUBLE,2,dims,time_samples.data(),0);
-    if(matvar!=NULL)
-    {
-        Mat_VarWrite(matfp, matvar, MAT_COMPRESSION_NONE);
-        Mat_VarFree(matvar);
-    }
-    else
-    {
-        yError() << "Could not save time samples.. the file will not be saved";
-        return false;
-    }
-
-//    if(all_keypoints.size() != 0)
-//        print(all_keypoints);
-
-    //Save keypoints
-    if(!writeStructToMat("Keypoints",all_keypoints,matfp))
-    {
-        yError() << "Could not save keypoints.. the file will not be saved";
-        return false;
-    }
-
-    //Save exercise
-    if(!writeStructToMat("Exercise",curr_exercise,matfp))
-    {
-        yError() << "Could not save exercise.. the file will not be saved";
-        return false;
-    }
-
-    return true;
-}
@@ -41,6 +41,7 @@ Rom::Rom(const string &type_, const string &name_, const string &tag_joint_,
          const string &tag_plane_, const Vector &ref_dir_, const string &ref_joint_,
          const double &minv_, const double &maxv_)
 {
+    kind=MetricKind::rom;
     type=type_;
     name=name_;
     tag_joint=tag_joint_;
@@ -54,6 +55,8 @@ Rom::Rom(const string &type_, const string &name_, const string &tag_joint_,
 
 Rom::Rom(const Rom &r)
 {
+    kind=r.kind;
+    type=r.type;
     name=r.name;
     tag_joint=r.tag_joint;
     tag_plane=r.tag_plane;
@@ -66,6 +69,8 @@ Rom::Rom(const Rom &r)
 
 Rom& Rom::operator = (const Rom &r)
 {
+    kind=r.kind;
+    type=r.type;
     name=r.name;
     tag_joint=r.tag_joint;
     tag_plane=r.tag_plane;
@@ -113,6 +118,7 @@ yarp::os::Property Rom::getParams() const
 Step::Step(const string &type_, const string &name_, const yarp::sig::Vector &num_,
            const yarp::sig::Vector &den_, const double &minv_, const double &maxv_)
 {
+    kind=MetricKind::step;
     type=type_;
     name=name_;
     num=num_;
@@ -128,6 +134,7 @@ Step::Step(const string &type_, const string &name_, const yarp::sig::Vector &nu
 
 Step::Step(const Step &r)
 {
+    kind=r.kind;
     type=r.type;
     name=r.name;
     num=r.num;
@@ -139,6 +146,7 @@ Step::Step(const Step &r)
 
 Step& Step::operator = (const Step &r)
 {
+    kind=r.kind;
     type=r.type;
     name=r.name;
     num=r.num;
@@ -182,6 +190,7 @@ EndPoint::EndPoint(const string &type_, const string &name_, const string &tag_j
                    const string &tag_plane_, const Vector &ref_dir_, const double &minv_,
                    const double &maxv_, const Vector &target_)
 {
+    kind=MetricKind::end_point;
     type=type_;
     name=name_;
     tag_joint=tag_joint_;
@@ -198,6 +207,7 @@ EndPoint::EndPoint(const string &type_, const string &name_, const string &tag_j
 
 EndPoint::EndPoint(const EndPoint &ep)
 {
+    kind=ep.kind;
     type=ep.type;
     name=ep.name;
     tag_joint=ep.tag_joint;
@@ -211,6 +221,7 @@ EndPoint::EndPoint(const EndPoint &ep)
 
 EndPoint& EndPoint::operator = (const EndPoint &ep)
 {
+    kind=ep.kind;
     type=ep.type;
     name=ep.name;
     tag_joint=ep.tag_joint;
@@ -0,0 +1,80 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Patient.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include "Patient.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace assistive_rehab;
+
+/********************************************************/
+Patient::Patient(const string &tag) : tag(tag), exercise(NULL), updated(false), initialized(false)
+{
+
+}
+
+/********************************************************/
+Patient::~Patient()
+{
+    release();
+}
+
+/********************************************************/
+void Patient::release()
+{
+    for(size_t i=0; i<processors.size(); i++)
+    {
+        delete processors[i];
+    }
+    processors.clear();
+}
+
+/********************************************************/
+void Patient::setExercise(const Exercise *exercise)
+{
+    release();
+    this->exercise=exercise;
+    vector<const Metric*> metrics=exercise->getMetrics();
+    for(size_t i=0; i<metrics.size(); i++)
+    {
+        if(Processor *processor=createProcessor(metrics[i]))
+        {
+            processors.push_back(processor);
+        }
+    }
+    initialized=false;
+}
+
+/********************************************************/
+void Patient::update(const OpcClient &opc)
+{
+    if(opc.getSkeleton(tag,skeleton))
+    {
+        updated=true;
+    }
+}
+
+/********************************************************/
+void Patient::init(const SkeletonSnapshot &snapshot)
+{
+    //as for the selected skeleton, only rehabilitation needs a reference frame
+    if(exercise!=NULL && exercise->getType()==ExerciseType::rehabilitation)
+    {
+        Matrix T;
+        for(size_t i=0; i<processors.size(); i++)
+        {
+            processors[i]->setInitialConf(snapshot,T);
+        }
+    }
+    initialized=true;
+}
@@ -12,6 +12,7 @@
 
 #include "Processor.h"
 #include <iomanip>
+#include <algorithm>
 
 using namespace std;
 using namespace yarp::sig;
@@ -23,22 +24,27 @@ using namespace assistive_rehab;
 /****************************************/
 /*             PROCESSOR                */
 /****************************************/
-Processor *createProcessor(const string& metric_type, const Metric* metric_)
+template<class T>
+Processor *makeProcessor(const Metric* metric_)
 {
-    if(metric_type.find(MetricType::rom)!=std::string::npos)
-    {
-        yInfo() << "Creating processor for" << MetricType::rom << "\n";
-        return new Rom_Processor(metric_);
-    }
-    else if(metric_type.find(MetricType::step)!=std::string::npos)
-    {
-        yInfo() << "Creating processor for" << MetricType::step << "\n";
-        return new Step_Processor(metric_);
-    }
-    else if(metric_type.find(MetricType::end_point)!=std::string::npos)
+    return new T(metric_);
+}
+
+//indexed by MetricKind, no string matching when switching exercise
+typedef Processor* (*ProcessorFactory)(const Metric*);
+static const ProcessorFactory processorFactories[]=
+{
+    makeProcessor<Rom_Processor>,       //MetricKind::rom
+    makeProcessor<Step_Processor>,      //MetricKind::step
+    makeProcessor<EndPoint_Processor>   //MetricKind::end_point
+};
+
+Processor *createProcessor(const Metric* metric_)
+{
+    size_t kind=static_cast<size_t>(metric_->getKind());
+    if(kind<sizeof(processorFactories)/sizeof(processorFactories[0]))
     {
-        yInfo() << "Creating processor for" << MetricType::end_point << "\n";
-        return new EndPoint_Processor(metric_);
+        return processorFactories[kind](metric_);
     }
     else
         return 0;
@@ -65,12 +71,12 @@ void print(const Matrix& m)
 }
 
 /********************************************************/
-void Processor::setInitialConf(SkeletonStd &skeleton_, Matrix &T)
+void Processor::setInitialConf(const SkeletonSnapshot &snapshot, Matrix &T)
 {
-    first_skeleton.update(skeleton_.toProperty());
-    first_skeleton.normalize();
+    first_snapshot=snapshot;
+    const SkeletonStd &first_skeleton=first_snapshot->getNormalized();
 
-    if(!first_skeleton.update_planes())
+    if(!first_snapshot->arePlanesUpdated())
         yError() << "Not all planes are updated";
 
     Vector coronal = first_skeleton.getCoronal();
@@ -90,9 +96,40 @@ void Processor::setInitialConf(SkeletonStd &skeleton_, Matrix &T)
 }
 
 /****************************************************************/
-void Processor::update(SkeletonStd &curr_skeleton_)
+void Processor::update(const SkeletonSnapshot &snapshot)
+{
+    curr_snapshot=snapshot;
+}
+
+/****************************************************************/
+void Processor::setProperties(const Metric *metric, const size_t n)
+{
+    props=metric->getProperties();
+    result.assign(std::max(props.size(),n),0.0);
+}
+
+/****************************************************************/
+int Processor::getIndex(const string &prop) const
 {
-    curr_skeleton.update(curr_skeleton_.toProperty());
+    for(size_t i=0; i<props.size(); i++)
+    {
+        if(props[i]==prop)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/****************************************************************/
+Property Processor::getResult() const
+{
+    Property res;
+    for(size_t i=0; i<props.size(); i++)
+    {
+        res.put(props[i],result[i]);
+    }
+    return res;
 }
 
 /****************************************************************/
@@ -103,9 +140,9 @@ Vector Processor::projectOnPlane(const Vector &v,const Vector &plane)
 }
 
 /****************************************************************/
-Vector Processor::toCurrFrame(const string &tag)
+Vector Processor::toCurrFrame(const Skeleton &skeleton, const string &tag)
 {
-    Vector k=curr_skeleton[tag]->getPoint();
+    Vector k=skeleton[tag]->getPoint();
     k.push_back(1.0);
     return (curr_frame*k).subVector(0,2);
 }
@@ -122,6 +159,7 @@ Rom_Processor::Rom_Processor()
 Rom_Processor::Rom_Processor(const Metric* rom_)
 {
     rom=(Rom*)rom_;
+    setProperties(rom,1);
     prev_range=0.0;
 }
 
@@ -132,7 +170,7 @@ void Rom_Processor::estimate()
     Vector ref_dir(3,0.0);
 
     //get reference keypoint from skeleton
-    curr_skeleton.normalize();
+    const SkeletonStd &curr_skeleton=curr_snapshot->getNormalized();
     string tag_joint=rom->getTagJoint();
     if(curr_skeleton[tag_joint]->isUpdated() && curr_skeleton[tag_joint]->getChild(0)->isUpdated())
     {
@@ -151,8 +189,8 @@ void Rom_Processor::estimate()
             {
                 plane_normal=curr_skeleton.getTransverse();
             }
-            Vector k1=toCurrFrame(tag_joint);
-            Vector k2=toCurrFrame(curr_skeleton[tag_joint]->getChild(0)->getTag());
+            Vector k1=toCurrFrame(curr_skeleton,tag_joint);
+            Vector k2=toCurrFrame(curr_skeleton,curr_skeleton[tag_joint]->getChild(0)->getTag());
             v1=k2-k1;
             v1=projectOnPlane(v1,plane_normal);
             double n1=norm(v1);
@@ -160,7 +198,7 @@ void Rom_Processor::estimate()
                 v1/=n1;
             if(!rom->getRefJoint().empty())
             {
-                Vector k_dir=toCurrFrame(rom->getRefJoint());
+                Vector k_dir=toCurrFrame(curr_skeleton,rom->getRefJoint());
                 ref_dir=k1-k_dir;
             }
             else
@@ -183,15 +221,7 @@ void Rom_Processor::estimate()
     {
         range=prev_range;
     }
-}
-
-/********************************************************/
-yarp::os::Property Rom_Processor::getResult()
-{
-    Property result;
-    vector<string> props=rom->getProperties();
-    result.put(props[0],range);
-    return result;
+    result[0]=range;
 }
 
 /****************************************/
@@ -206,9 +236,17 @@ Step_Processor::Step_Processor()
 Step_Processor::Step_Processor(const Metric* step_)
 {
     step=(Step*)step_;
+    setProperties(step,4);
     filter_dist=new Filter(step->getNum(),step->getDen());
-    filter_width=new Filter(step->getNum(),step->getDen());
 
+    //samples to wait after a candidate peak before confirming it
+    lookahead=1;
+
+    steplen=0.0;
+    stepwidth=0.0;
+    numsteps=0;
+    cadence=0.0;
+    speed=0.0;
     prev_steplen=0.0;
     prev_stepwidth=0.0;
     prev_cadence=0.0;
@@ -218,20 +256,20 @@ Step_Processor::Step_Processor(const Metric* step_)
 /********************************************************/
 void Step_Processor::estimate()
 {
+    //distances between feet are in metric units
+    const SkeletonStd &curr_skeleton=curr_snapshot->getRaw();
     if(curr_skeleton[KeyPointTag::ankle_left]->isUpdated() &&
             curr_skeleton[KeyPointTag::ankle_right]->isUpdated())
     {
-        Vector k1=toCurrFrame(KeyPointTag::ankle_left);
-        Vector k2=toCurrFrame(KeyPointTag::ankle_right);
+        Vector k1=toCurrFrame(curr_skeleton,KeyPointTag::ankle_left);
+        Vector k2=toCurrFrame(curr_skeleton,KeyPointTag::ankle_right);
         Vector v=k1-k2;
         double dist=norm(v);
-        feetdist.push_back(dist);
 
         Vector cor_plane=curr_skeleton.getCoronal();
         Vector v_stepwidth=projectOnPlane(v,cor_plane);
-        feetwidth.push_back(norm(v_stepwidth));
 
-        estimateSpatialParams(feetdist,feetwidth);
+        estimateSpatialParams(dist,norm(v_stepwidth));
         cadence=estimateCadence();
         speed=estimateSpeed();
 
@@ -247,45 +285,33 @@ void Step_Processor::estimate()
         cadence=prev_cadence;
         speed=prev_speed;
     }
+    result[0]=steplen;
+    result[1]=stepwidth;
+    result[2]=cadence;
+    result[3]=speed;
 //    yInfo()<<"Step parameters:"<<Time::now()-t0<<steplen<<stepwidth<<cadence<<speed<<numsteps;
 }
 
 /********************************************************/
-Property Step_Processor::getResult()
+void Step_Processor::estimateSpatialParams(const double dist,const double width)
 {
-    Property result;
-    vector<string> props=step->getProperties();
-    result.put(props[0],steplen);
-    result.put(props[1],stepwidth);
-    result.put(props[2],cadence);
-    result.put(props[3],speed);
-    return result;
-}
+    //each sample goes through the filter only once
+    Vector u(1,dist);
+    double filt_dist=filter_dist->filt(u)[0];
 
-/********************************************************/
-void Step_Processor::estimateSpatialParams(const Vector &dist,const Vector &width)
-{
-    Vector filt_dist(dist.size()),filt_width(width.size());
-    for(int i=0; i<dist.size(); i++)
+    //only the samples around the candidate peak are retained
+    window.push_back(make_pair(filt_dist,width));
+    if(window.size()>2*lookahead+1)
     {
-        Vector u1(1),u2(1);
-        u1[0]=dist[i];
-        u2[0]=width[i];
-        Vector output1=filter_dist->filt(u1);
-        Vector output2=filter_width->filt(u2);
-        filt_dist[i]=output1[0];
-        filt_width[i]=output2[0];
+        window.pop_front();
     }
 
-    pair<vector<double>,vector<int>> step_params;
-    step_params=findPeaks(filt_dist);
-    vector<double> stepvec=step_params.first;
-    vector<int> strikes=step_params.second;
-
-    steplen=stepvec.size()>0 ? stepvec.back() : 0.0;
-    int laststrike=strikes.size()>0 ? strikes.back() : 0.0;
-    stepwidth=feetwidth[laststrike];
-    numsteps=(int)strikes.size();
+    if(window.size()==2*lookahead+1 && isPeak())
+    {
+        steplen=window[lookahead].first;
+        stepwidth=window[lookahead].second;
+        numsteps++;
+    }
 }
 
 /********************************************************/
@@ -301,39 +327,24 @@ double Step_Processor::estimateSpeed()
 }
 
 /********************************************************/
-pair<vector<double>,vector<int>> Step_Processor::findPeaks(const Vector& d)
+bool Step_Processor::isPeak() const
 {
-    vector<double> val;
-    vector<int> idx;
-    for(int i=0; i<d.size(); i++)
+    //strict on the left, so that plateaus yield one peak only
+    double d=window[lookahead].first;
+    for(size_t i=0; i<window.size(); i++)
     {
-        if(i==0 && d[i]>=d[i+1])
-        {
-            val.push_back(d[i]);
-            idx.push_back(i);
-        }
-        else if(i==d.size() && d[i]>=d[i-1])
-        {
-            val.push_back(d[i]);
-            idx.push_back(i);
-        }
-        else if(d[i]>=d[i-1] && d[i]>=d[i+1])
+        if((i<lookahead && window[i].first>=d) || (i>lookahead && window[i].first>d))
         {
-            val.push_back(d[i]);
-            idx.push_back(i);
+            return false;
         }
     }
-
-    pair<vector<double>,vector<int>> step_params;
-    step_params=make_pair(val,idx);
-    return step_params;
+    return true;
 }
 
 /********************************************************/
 Step_Processor::~Step_Processor()
 {
     delete filter_dist;
-    delete filter_width;
 }
 
 /****************************************/
@@ -348,8 +359,9 @@ EndPoint_Processor::EndPoint_Processor()
 EndPoint_Processor::EndPoint_Processor(const Metric *ep_)
 {
     ep=(EndPoint*)ep_;
-    linEst=new AWLinEstimator(16,0.5);
-    jerkEst=new JerkEstimator(16,0.1);
+    setProperties(ep,3);
+    velEst=new DerivativeEstimator(3,10,2);
+    jerkEst=new DerivativeEstimator(3,16,3);
     ideal_traj=0.0;
     prev_est_traj=0.0;
     prev_ideal_traj=0.0;
@@ -360,7 +372,7 @@ EndPoint_Processor::EndPoint_Processor(const Metric *ep_)
 /********************************************************/
 EndPoint_Processor::~EndPoint_Processor()
 {
-    delete linEst;
+    delete velEst;
     delete jerkEst;
 }
 
@@ -374,10 +386,12 @@ void EndPoint_Processor::estimate()
     else if(ep->getTagPlane() == "transverse")
         plane_normal[2]=1.0;
 
-    curr_skeleton.normalize();
+    const SkeletonStd &curr_skeleton=curr_snapshot->getNormalized();
     string tag_joint = ep->getTagJoint();
-    if(curr_skeleton[tag_joint]->isUpdated())
+    //no reference frame until the initial configuration is set
+    if(first_snapshot && curr_skeleton[tag_joint]->isUpdated())
     {
+        const SkeletonStd &first_skeleton=first_snapshot->getNormalized();
         //we compute ideal and current trajectory wrt left/right shoulder
         Vector ref = first_skeleton[tag_joint]->getParent(0)->getParent(0)->getPoint();
         ref.push_back(1.0);
@@ -399,9 +413,11 @@ void EndPoint_Processor::estimate()
         ideal_traj = getTrajectory(dt);
 
         //we compute velocity and smoothness of the end-point
-        AWPolyElement el(transformed_v,Time::now());
-        vel=norm(linEst->estimate(el));
-        smoothness = norm(jerkEst->estimate(el));
+        double now=Time::now();
+        velEst->estimate(transformed_v,now);
+        jerkEst->estimate(transformed_v,now);
+        vel=norm(velEst->getVelocity());
+        smoothness=norm(jerkEst->getJerk());
 
         prev_est_traj=est_traj;
         prev_ideal_traj=ideal_traj;
@@ -415,20 +431,12 @@ void EndPoint_Processor::estimate()
         vel=prev_vel;
         smoothness=prev_smoothness;
     }
+    result[0]=est_traj;
+    result[1]=vel;
+    result[2]=smoothness;
 
 }
 
-/********************************************************/
-Property EndPoint_Processor::getResult()
-{
-    Property result;
-    vector<string> props=ep->getProperties();
-    result.put(props[0],est_traj);
-    result.put(props[1],vel);
-    result.put(props[2],smoothness);
-    return result;
-}
-
 /********************************************************/
 double EndPoint_Processor::getTrajectory(const Vector &v)
 {
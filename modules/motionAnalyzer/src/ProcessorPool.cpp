@@ -0,0 +1,115 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file ProcessorPool.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include "ProcessorPool.h"
+
+using namespace std;
+using namespace yarp::os;
+
+/********************************************************/
+ProcessorPool::ProcessorPool() : jobs(NULL), next(0), pending(0), closing(false)
+{
+
+}
+
+/********************************************************/
+ProcessorPool::~ProcessorPool()
+{
+    close();
+}
+
+/********************************************************/
+void ProcessorPool::open(const int nthreads)
+{
+    close();
+    closing=false;
+
+    //with one thread only, jobs are run by the caller
+    for(int i=0; i<nthreads-1; i++)
+    {
+        Worker *worker=new Worker(this);
+        worker->start();
+        workers.push_back(worker);
+    }
+}
+
+/********************************************************/
+void ProcessorPool::work()
+{
+    unique_lock<mutex> lck(mtx);
+    while(true)
+    {
+        cv_job.wait(lck,[this]() { return closing || (jobs!=NULL && next<jobs->size()); });
+        if(closing)
+        {
+            return;
+        }
+
+        function<void()> &job=(*jobs)[next++];
+        lck.unlock();
+        job();
+        lck.lock();
+        if(--pending==0)
+        {
+            cv_done.notify_all();
+        }
+    }
+}
+
+/********************************************************/
+void ProcessorPool::run(vector<function<void()>> &jobs)
+{
+    if(workers.empty())
+    {
+        for(auto &job:jobs)
+        {
+            job();
+        }
+        return;
+    }
+
+    unique_lock<mutex> lck(mtx);
+    this->jobs=&jobs;
+    next=0;
+    pending=jobs.size();
+    cv_job.notify_all();
+
+    //the caller takes part in the evaluation too
+    while(next<jobs.size())
+    {
+        function<void()> &job=jobs[next++];
+        lck.unlock();
+        job();
+        lck.lock();
+        pending--;
+    }
+
+    cv_done.wait(lck,[this]() { return pending==0; });
+    this->jobs=NULL;
+}
+
+/********************************************************/
+void ProcessorPool::close()
+{
+    {
+        lock_guard<mutex> lg(mtx);
+        closing=true;
+    }
+    cv_job.notify_all();
+
+    for(auto &worker:workers)
+    {
+        worker->stop();
+        delete worker;
+    }
+    workers.clear();
+}
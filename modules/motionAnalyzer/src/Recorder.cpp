@@ -0,0 +1,527 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Recorder.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include <zlib.h>
+
+#include "Recorder.h"
+#include "matio.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace assistive_rehab;
+
+namespace
+{
+
+//MAT v5 data types and array classes
+const uint32_t miINT8=1;
+const uint32_t miINT32=5;
+const uint32_t miUINT32=6;
+const uint32_t miDOUBLE=9;
+const uint32_t miMATRIX=14;
+const uint32_t miCOMPRESSED=15;
+const uint32_t mxSTRUCT_CLASS=2;
+const uint32_t mxDOUBLE_CLASS=6;
+
+/********************************************************/
+size_t padded(const size_t n)
+{
+    return (n+7)&~(size_t)7;
+}
+
+/********************************************************/
+size_t matrixSize(const string &name, const size_t rows, const size_t cols)
+{
+    //flags, dimensions, name and real part
+    return 16+16+8+padded(name.size())+8+8*rows*cols;
+}
+
+//one compressed variable written to file as its content is produced,
+//the sizes of its elements being known in advance
+class MatStream
+{
+    FILE *fp;
+    long start;
+    z_stream zs;
+    vector<unsigned char> buffer;
+    bool ok;
+
+    void flush(const int mode)
+    {
+        do
+        {
+            zs.next_out=buffer.data();
+            zs.avail_out=(uInt)buffer.size();
+            if(deflate(&zs,mode)==Z_STREAM_ERROR)
+            {
+                ok=false;
+                return;
+            }
+            size_t n=buffer.size()-zs.avail_out;
+            ok=ok && (fwrite(buffer.data(),1,n,fp)==n);
+        } while(zs.avail_out==0);
+    }
+
+    void tag(const uint32_t type, const size_t n)
+    {
+        uint32_t t[2]={type,(uint32_t)n};
+        write(t,sizeof(t));
+    }
+
+    void pad(const size_t n)
+    {
+        const char zeros[8]={0};
+        write(zeros,padded(n)-n);
+    }
+
+public:
+    MatStream(FILE *fp, const int level) : fp(fp), buffer(1<<16), ok(true)
+    {
+        //the size of the compressed element is known only at the end
+        start=ftell(fp);
+        uint32_t t[2]={miCOMPRESSED,0};
+        ok=(fwrite(t,sizeof(t),1,fp)==1);
+        memset(&zs,0,sizeof(zs));
+        ok=ok && (deflateInit(&zs,level)==Z_OK);
+    }
+
+    void write(const void *data, const size_t n)
+    {
+        zs.next_in=(Bytef*)data;
+        zs.avail_in=(uInt)n;
+        flush(Z_NO_FLUSH);
+    }
+
+    //header of a double matrix, whose columns are written next
+    void matrix(const string &name, const size_t rows, const size_t cols)
+    {
+        tag(miMATRIX,matrixSize(name,rows,cols));
+        tag(miUINT32,8);
+        uint32_t flags[2]={mxDOUBLE_CLASS,0};
+        write(flags,sizeof(flags));
+        tag(miINT32,8);
+        int32_t dims[2]={(int32_t)rows,(int32_t)cols};
+        write(dims,sizeof(dims));
+        tag(miINT8,name.size());
+        write(name.data(),name.size());
+        pad(name.size());
+        tag(miDOUBLE,8*rows*cols);
+    }
+
+    //header of a 1x1 struct, whose fields are all rows x cols double matrices
+    void structure(const string &name, const vector<string> &fields,
+                   const size_t rows, const size_t cols)
+    {
+        size_t len=1;
+        for(auto &f:fields)
+        {
+            len=std::max(len,f.size()+1);
+        }
+        size_t names=len*fields.size();
+        size_t size=16+16+8+padded(name.size())+8+8+padded(names)+
+                    fields.size()*(8+matrixSize("",rows,cols));
+
+        tag(miMATRIX,size);
+        tag(miUINT32,8);
+        uint32_t flags[2]={mxSTRUCT_CLASS,0};
+        write(flags,sizeof(flags));
+        tag(miINT32,8);
+        int32_t dims[2]={1,1};
+        write(dims,sizeof(dims));
+        tag(miINT8,name.size());
+        write(name.data(),name.size());
+        pad(name.size());
+
+        //the length of the field names is a small data element
+        uint32_t field_len[2]={(4<<16)|miINT32,(uint32_t)len};
+        write(field_len,sizeof(field_len));
+        tag(miINT8,names);
+        vector<char> buf(padded(names),0);
+        for(size_t i=0; i<fields.size(); i++)
+        {
+            memcpy(&buf[i*len],fields[i].c_str(),fields[i].size());
+        }
+        write(buf.data(),buf.size());
+    }
+
+    bool close()
+    {
+        flush(Z_FINISH);
+        deflateEnd(&zs);
+
+        long end=ftell(fp);
+        uint32_t size=(uint32_t)(end-start-8);
+        ok=ok && (fseek(fp,start+4,SEEK_SET)==0);
+        ok=ok && (fwrite(&size,sizeof(size),1,fp)==1);
+        ok=ok && (fseek(fp,0,SEEK_END)==0);
+        return ok;
+    }
+};
+
+}
+
+/********************************************************/
+Recorder::Recorder() : chunk_size(100), compression(4), opened(false),
+    closing(false), file(-1), nframes(0)
+{
+
+}
+
+/********************************************************/
+void Recorder::setChunkSize(const size_t chunk_size)
+{
+    this->chunk_size=std::max(chunk_size,(size_t)1);
+}
+
+/********************************************************/
+hid_t Recorder::createDataset(const string &name, const size_t cols)
+{
+    //rows are appended chunk by chunk, each chunk is compressed
+    hsize_t dims[2]={0,cols};
+    hsize_t maxdims[2]={H5S_UNLIMITED,cols};
+    hsize_t chunk[2]={chunk_size,cols};
+    hid_t space=H5Screate_simple(2,dims,maxdims);
+    hid_t plist=H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(plist,2,chunk);
+    H5Pset_deflate(plist,compression);
+    hid_t dataset=H5Dcreate2(file,name.c_str(),H5T_NATIVE_DOUBLE,space,
+                             H5P_DEFAULT,plist,H5P_DEFAULT);
+    H5Pclose(plist);
+    H5Sclose(space);
+    return dataset;
+}
+
+/********************************************************/
+bool Recorder::append(hid_t dataset, const vector<double> &data, const size_t n, const size_t cols)
+{
+    hsize_t dims[2]={nframes+n,cols};
+    if(H5Dset_extent(dataset,dims)<0)
+    {
+        return false;
+    }
+
+    hsize_t start[2]={nframes,0};
+    hsize_t count[2]={n,cols};
+    hid_t filespace=H5Dget_space(dataset);
+    H5Sselect_hyperslab(filespace,H5S_SELECT_SET,start,NULL,count,NULL);
+    hid_t memspace=H5Screate_simple(2,count,NULL);
+    herr_t ret=H5Dwrite(dataset,H5T_NATIVE_DOUBLE,memspace,filespace,H5P_DEFAULT,data.data());
+    H5Sclose(memspace);
+    H5Sclose(filespace);
+    return ret>=0;
+}
+
+/********************************************************/
+bool Recorder::readColumn(hid_t dataset, const size_t col, vector<double> &data)
+{
+    data.resize(nframes);
+    if(data.empty())
+    {
+        return true;
+    }
+
+    hsize_t start[2]={0,col};
+    hsize_t count[2]={nframes,1};
+    hid_t filespace=H5Dget_space(dataset);
+    H5Sselect_hyperslab(filespace,H5S_SELECT_SET,start,NULL,count,NULL);
+    hid_t memspace=H5Screate_simple(2,count,NULL);
+    herr_t ret=H5Dread(dataset,H5T_NATIVE_DOUBLE,memspace,filespace,H5P_DEFAULT,data.data());
+    H5Sclose(memspace);
+    H5Sclose(filespace);
+    return ret>=0;
+}
+
+/********************************************************/
+bool Recorder::create(const Session &session)
+{
+    file=H5Fcreate((session.basename+".h5").c_str(),H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT);
+    if(file<0)
+    {
+        yError()<<"Could not create"<<session.basename+".h5";
+        return false;
+    }
+
+    hid_t group=H5Gcreate2(file,"/Keypoints",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+    H5Gclose(group);
+
+    datasets.clear();
+    datasets.push_back(createDataset("/Time_samples",1));
+    for(auto &tag:session.tags)
+    {
+        datasets.push_back(createDataset("/Keypoints/"+tag,3));
+    }
+    nframes=0;
+    return true;
+}
+
+/********************************************************/
+bool Recorder::open(const string &basename, const Skeleton &skeleton)
+{
+    //the previous session is written and exported in background,
+    //the file of this one is created by the thread
+    shared_ptr<Session> session=make_shared<Session>();
+    session->basename=basename;
+    for(auto &it:skeleton.get_unordered())
+    {
+        session->tags.push_back(it.first);
+    }
+    session->keypoints.assign(session->tags.size(),vector<double>());
+    session->finished=false;
+
+    {
+        lock_guard<mutex> lg(mtx);
+        if(closing)
+        {
+            return false;
+        }
+        if(opened)
+        {
+            sessions.back()->finished=true;
+        }
+        sessions.push_back(session);
+        opened=true;
+    }
+    cv.notify_one();
+
+    yInfo()<<"Recording session to"<<basename+".h5";
+    return (isRunning() || start());
+}
+
+/********************************************************/
+void Recorder::push(const double t, const Skeleton &skeleton)
+{
+    if(!opened)
+    {
+        return;
+    }
+
+    lock_guard<mutex> lg(mtx);
+    Session &session=*sessions.back();
+    session.time.push_back(t);
+    for(size_t i=0; i<session.tags.size(); i++)
+    {
+        const Vector &p=skeleton[session.tags[i]]->getPoint();
+        session.keypoints[i].insert(session.keypoints[i].end(),p.begin(),p.begin()+3);
+    }
+
+    if(session.time.size()>=chunk_size)
+    {
+        cv.notify_one();
+    }
+}
+
+/********************************************************/
+void Recorder::finish()
+{
+    //the last chunk and the export are handled by the thread
+    {
+        lock_guard<mutex> lg(mtx);
+        if(opened)
+        {
+            sessions.back()->finished=true;
+        }
+        opened=false;
+    }
+    cv.notify_one();
+}
+
+/********************************************************/
+void Recorder::writeChunk(const vector<double> &time, const vector<vector<double>> &keypoints)
+{
+    size_t n=time.size();
+    bool ok=append(datasets[0],time,n,1);
+    for(size_t i=0; i<keypoints.size(); i++)
+    {
+        ok=ok && append(datasets[i+1],keypoints[i],n,3);
+    }
+    if(!ok)
+    {
+        yError()<<"Could not append chunk to"<<current->basename+".h5";
+    }
+
+    nframes+=n;
+    H5Fflush(file,H5F_SCOPE_LOCAL);
+}
+
+/********************************************************/
+bool Recorder::exportToMat(const Session &session)
+{
+    //the session metadata may have been written already
+    string filename=session.basename+".mat";
+    mat_t *matfp=Mat_Open(filename.c_str(),MAT_ACC_RDONLY);
+    if(matfp==NULL)
+    {
+        matfp=Mat_CreateVer(filename.c_str(),NULL,MAT_FT_MAT5);
+    }
+    if(matfp==NULL)
+    {
+        yError()<<"Error opening MAT file";
+        return false;
+    }
+    Mat_Close(matfp);
+
+    //variables are appended as compressed elements, one column at a time,
+    //since matio would need the whole session in memory
+    FILE *fp=fopen(filename.c_str(),"r+b");
+    if(fp==NULL || fseek(fp,0,SEEK_END)!=0)
+    {
+        yError()<<"Error opening MAT file";
+        if(fp!=NULL)
+        {
+            fclose(fp);
+        }
+        return false;
+    }
+
+    vector<double> column;
+    bool ok=true;
+    {
+        MatStream stream(fp,compression);
+        stream.matrix("Time_samples",nframes,1);
+        ok=readColumn(datasets[0],0,column);
+        stream.write(column.data(),column.size()*sizeof(double));
+        ok=stream.close() && ok;
+    }
+
+    {
+        MatStream stream(fp,compression);
+        stream.structure("Keypoints",session.tags,nframes,3);
+        for(size_t i=0; i<session.tags.size(); i++)
+        {
+            stream.matrix("",nframes,3);
+            for(size_t j=0; j<3; j++)
+            {
+                ok=readColumn(datasets[i+1],j,column) && ok;
+                stream.write(column.data(),column.size()*sizeof(double));
+            }
+        }
+        ok=stream.close() && ok;
+    }
+    ok=(fclose(fp)==0) && ok;
+
+    if(!ok)
+    {
+        yError()<<"Could not save keypoints to file"<<filename;
+        return false;
+    }
+    yInfo()<<"Keypoints saved to file"<<filename;
+    return true;
+}
+
+/********************************************************/
+void Recorder::finalize()
+{
+    if(file<0)
+    {
+        return;
+    }
+
+    bool ok=exportToMat(*current);
+    release();
+    if(ok)
+    {
+        remove((current->basename+".h5").c_str());
+    }
+    else
+    {
+        yError()<<"Session kept in"<<current->basename+".h5";
+    }
+}
+
+/********************************************************/
+void Recorder::release()
+{
+    for(auto &dataset:datasets)
+    {
+        H5Dclose(dataset);
+    }
+    datasets.clear();
+    H5Fclose(file);
+    file=-1;
+}
+
+/********************************************************/
+void Recorder::onStop()
+{
+    //pending sessions are written and exported before the thread quits
+    {
+        lock_guard<mutex> lg(mtx);
+        for(auto &session:sessions)
+        {
+            session->finished=true;
+        }
+        closing=true;
+        opened=false;
+    }
+    cv.notify_one();
+}
+
+/********************************************************/
+void Recorder::run()
+{
+    while(true)
+    {
+        shared_ptr<Session> session;
+        vector<double> time;
+        vector<vector<double>> keypoints;
+        bool finished;
+        {
+            unique_lock<mutex> lck(mtx);
+            cv.wait(lck,[this]() {
+                if(sessions.empty())
+                {
+                    return closing;
+                }
+                return (sessions.front()->finished ||
+                        (sessions.front()->time.size()>=chunk_size));
+            });
+            if(sessions.empty())
+            {
+                break;
+            }
+
+            session=sessions.front();
+            time.swap(session->time);
+            keypoints.assign(session->keypoints.size(),vector<double>());
+            for(size_t i=0; i<keypoints.size(); i++)
+            {
+                keypoints[i].swap(session->keypoints[i]);
+            }
+            finished=session->finished;
+            if(finished)
+            {
+                sessions.pop_front();
+            }
+        }
+
+        if(session!=current)
+        {
+            current=session;
+            create(*current);
+        }
+        if(file>=0 && !time.empty())
+        {
+            writeChunk(time,keypoints);
+        }
+        if(finished)
+        {
+            finalize();
+            current.reset();
+        }
+    }
+}
@@ -0,0 +1,324 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Repertoire.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include "Repertoire.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+
+/********************************************************/
+Repertoire::Repertoire()
+{
+
+}
+
+/********************************************************/
+Repertoire::~Repertoire()
+{
+    for(auto &it:exercises)
+    {
+        delete it.second;
+    }
+}
+
+/********************************************************/
+bool Repertoire::load(const string &context, const string &from)
+{
+    ResourceFinder rf;
+    rf.setVerbose();
+    rf.setDefaultContext(context.c_str());
+    rf.setDefaultConfigFile(from.c_str());
+    rf.configure(0,NULL);
+
+    Bottle &bGeneral = rf.findGroup("general");
+    if(!bGeneral.isNull())
+    {
+        if(Bottle *bExercises = bGeneral.find("exercises").asList())
+        {
+            int nexercises = bExercises->size();
+            for(int i=0; i<nexercises; i++)
+            {
+                Exercise *exercise=NULL;
+                string ex_tag = bExercises->get(i).asString();
+                Bottle &bExercise = rf.findGroup(ex_tag);
+                if(!bExercise.isNull())
+                {
+                    Bottle &bGeneral=bExercise.findGroup("general");
+                    if(!bGeneral.isNull())
+                    {
+                        string type=bGeneral.find("type").asString();
+                        if(ex_tag==ExerciseTag::abduction_left ||
+                                ex_tag==ExerciseTag::internal_rotation_left ||
+                                ex_tag==ExerciseTag::external_rotation_left)
+                        {
+                            exercise=new RangeOfMotion(ex_tag);
+                        }
+                        if(ex_tag==ExerciseTag::reaching_left)
+                        {
+                            exercise=new ReachingLeft();
+                        }
+                        if(ex_tag==ExerciseTag::tug)
+                        {
+                            exercise=new Tug();
+                        }
+                    }
+
+                    if(exercise==NULL)
+                    {
+                        yWarning() << "Unknown exercise" << ex_tag;
+                        continue;
+                    }
+
+                    //for each exercise we can evaluate different metrics
+                    //check which metric has to be evaluated for this exercise
+                    Bottle &bMetrics = bExercise.findGroup("metrics");
+                    if(!bMetrics.isNull())
+                    {
+                        Bottle *bMetricTags = bMetrics.find("tag").asList();
+                        Bottle *bMetricNumber = bMetrics.find("nmetrics").asList();
+                        if(!bMetricTags->isNull() && !bMetricNumber->isNull())
+                        {
+                            for(int j=0; j<bMetricTags->size(); j++)
+                            {
+                                string metric_type=bMetricTags->get(j).asString();
+                                int nmetrics=bMetricNumber->get(j).asInt();
+                                for(int k=0; k<nmetrics; k++)
+                                {                                   
+                                    string metric_tag=metric_type+"_"+to_string(k);
+                                    Bottle &bMetricEx=bExercise.findGroup(metric_tag);
+                                    if(!bMetricEx.isNull())
+                                    {
+                                        if(metric_type==MetricType::rom)
+                                        {
+                                            string tag_joint = bMetricEx.find("tag_joint").asString();
+                                            Vector ref_dir(3,0.0);
+                                            if(Bottle *bRefDir = bMetricEx.find("ref_dir").asList())
+                                            {
+                                                ref_dir[0] = bRefDir->get(0).asDouble();
+                                                ref_dir[1] = bRefDir->get(1).asDouble();
+                                                ref_dir[2] = bRefDir->get(2).asDouble();
+                                            }
+                                            string ref_joint=bMetricEx.check("ref_joint", Value("")).asString();;
+                                            string tag_plane=bMetricEx.find("tag_plane").asString();
+                                            double minv=bMetricEx.find("min").asDouble();
+                                            double maxv=bMetricEx.find("max").asDouble();
+
+                                            Metric *rom;
+                                            rom=new Rom(metric_type,metric_tag,tag_joint,tag_plane,ref_dir,ref_joint,minv,maxv);
+                                            exercise->addMetric(rom);
+                                        }                                      
+                                        if(metric_type==MetricType::step)
+                                        {
+                                            Bottle *bNum = bMetricEx.find("num").asList();
+                                            Bottle *bDen = bMetricEx.find("den").asList();
+                                            Vector num(6,0.0),den(6,0.0);
+                                            if(!bNum->isNull() && !bDen->isNull())
+                                            {
+                                                num[0] = bNum->get(0).asDouble();
+                                                num[1] = bNum->get(1).asDouble();
+                                                num[2] = bNum->get(2).asDouble();
+                                                num[3] = bNum->get(3).asDouble();
+                                                num[4] = bNum->get(4).asDouble();
+                                                num[5] = bNum->get(5).asDouble();
+
+                                                den[0] = bDen->get(0).asDouble();
+                                                den[1] = bDen->get(1).asDouble();
+                                                den[2] = bDen->get(2).asDouble();
+                                                den[3] = bDen->get(3).asDouble();
+                                                den[4] = bDen->get(4).asDouble();
+                                                den[5] = bDen->get(5).asDouble();
+                                            }
+                                            double minv=bMetricEx.find("min").asDouble();
+                                            double maxv=bMetricEx.find("max").asDouble();
+                                            Metric *step;
+                                            step=new Step(metric_type,metric_tag,num,den,minv,maxv);
+                                            exercise->addMetric(step);
+                                        }
+                                        if(metric_type==MetricType::end_point)
+                                        {
+                                            string tag_joint=bMetricEx.find("tag_joint").asString();
+                                            Vector ref_dir(3,0.0);
+                                            if(Bottle *bRefDir = bMetricEx.find("ref_dir").asList())
+                                            {
+                                                ref_dir[0] = bRefDir->get(0).asDouble();
+                                                ref_dir[1] = bRefDir->get(1).asDouble();
+                                                ref_dir[2] = bRefDir->get(2).asDouble();
+                                            }
+                                            string tag_plane=bMetricEx.find("tag_plane").asString();
+                                            double minv=bMetricEx.find("min").asDouble();
+                                            double maxv=bMetricEx.find("max").asDouble();
+                                            Vector target(3,0.0);
+                                            if(Bottle *bTarget=bMetricEx.find("target").asList())
+                                            {
+                                                target[0]=bTarget->get(0).asDouble();
+                                                target[1]=bTarget->get(1).asDouble();
+                                                target[2]=bTarget->get(2).asDouble();
+                                            }
+                                            Metric *ep;
+                                            ep=new EndPoint(metric_type,metric_tag,tag_joint,tag_plane,ref_dir,minv,maxv,target);
+                                            exercise->addMetric(ep);
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+
+                    //each exercise can have a specific feedback
+                    Bottle &bFeedback=bExercise.findGroup("feedback");
+                    if(!bFeedback.isNull())
+                    {
+                        Property feedparams;
+                        if(ex_tag==ExerciseTag::abduction_left ||
+                                ex_tag==ExerciseTag::internal_rotation_left ||
+                                ex_tag==ExerciseTag::external_rotation_left)
+                        {
+                            int duration=bFeedback.find("duration").asInt();
+                            double twarp=bFeedback.find("twarp").asDouble();
+                            vector<string> joint_list;
+                            if(Bottle *bJointList=bFeedback.find("joint_list").asList())
+                            {
+                                for(size_t k=0; k<bJointList->size(); k++)
+                                    joint_list.push_back(bJointList->get(k).asString());
+                            }
+                            Vector sx_thresh;
+                            if(Bottle *bSxThresh=bFeedback.find("sx_thresh").asList())
+                            {
+                                for(size_t k=0; k<bSxThresh->size(); k++)
+                                    sx_thresh.push_back(bSxThresh->get(k).asDouble());
+                            }
+                            Vector sy_thresh;
+                            if(Bottle *bSyThresh=bFeedback.find("sy_thresh").asList())
+                            {
+                                for(size_t k=0; k<bSyThresh->size(); k++)
+                                    sy_thresh.push_back(bSyThresh->get(k).asDouble());
+                            }
+                            Vector sz_thresh;
+                            if(Bottle *bSzThresh=bFeedback.find("sz_thresh").asList())
+                            {
+                                for(size_t k=0; k<bSzThresh->size(); k++)
+                                    sz_thresh.push_back(bSzThresh->get(k).asDouble());
+                            }
+                            Vector range_freq;
+                            if(Bottle *bFreqThresh=bFeedback.find("range_freq").asList())
+                            {
+                                for(size_t k=0; k<bFreqThresh->size(); k++)
+                                    range_freq.push_back(bFreqThresh->get(k).asInt());
+                            }
+                            Vector psd_thresh;
+                            if(Bottle *bPsdThresh=bFeedback.find("psd_thresh").asList())
+                            {
+                                for(size_t k=0; k<bPsdThresh->size(); k++)
+                                    psd_thresh.push_back(bPsdThresh->get(k).asDouble());
+                            }
+
+                            feedparams.clear();
+                            feedparams.put("duration",duration);
+                            feedparams.put("twarp",twarp);
+                            Property &p=feedparams.addGroup("thresh");
+                            Property &pjoint=p.addGroup("joint");
+                            Property &psx=p.addGroup("sx");
+                            Property &psy=p.addGroup("sy");
+                            Property &psz=p.addGroup("sz");
+                            Property &freq=p.addGroup("freq");
+                            Property &psd=p.addGroup("psd");
+                            for(int i=0;i<joint_list.size();i++)
+                            {
+                                pjoint.put("joint_"+to_string(i),joint_list[i]);
+                                psx.put("sx_thresh_"+to_string(i),sx_thresh[i]);
+                                psy.put("sy_thresh_"+to_string(i),sy_thresh[i]);
+                                psz.put("sz_thresh_"+to_string(i),sz_thresh[i]);
+                                freq.put("range_freq_"+to_string(i),range_freq[i]);
+                                psd.put("psd_thresh_"+to_string(i),psd_thresh[i]);
+                            }
+                        }
+                        if(ex_tag==ExerciseTag::reaching_left)
+                        {
+                            int duration=bFeedback.find("duration").asInt();
+                            double twarp=bFeedback.find("twarp").asDouble();
+                            vector<string> joint_list;
+                            if(Bottle *bJointList=bFeedback.find("joint_list").asList())
+                            {
+                                for(size_t k=0; k<bJointList->size(); k++)
+                                    joint_list.push_back(bJointList->get(k).asString());
+                            }
+                            Vector radius;
+                            if(Bottle *bRadius=bFeedback.find("radius").asList())
+                            {
+                                for(size_t k=0; k<bRadius->size(); k++)
+                                    radius.push_back(bRadius->get(k).asDouble());
+                            }
+                            Vector zscore;
+                            if(Bottle *bZscore=bFeedback.find("zscore_thresh").asList())
+                            {
+                                for(size_t k=0; k<bZscore->size(); k++)
+                                    zscore.push_back(bZscore->get(k).asDouble());
+                            }
+                            Vector inliers;
+                            if(Bottle *bInliersThresh=bFeedback.find("inliers_thresh").asList())
+                            {
+                                for(size_t k=0; k<bInliersThresh->size(); k++)
+                                    inliers.push_back(bInliersThresh->get(k).asDouble());
+                            }
+
+                            feedparams.clear();
+                            feedparams.put("duration",duration);
+                            feedparams.put("twarp",twarp);
+                            Property &p=feedparams.addGroup("thresh");
+                            Property &pjoint=p.addGroup("joint");
+                            Property &pr=p.addGroup("radius");
+                            Property &pscore=p.addGroup("zscore_thresh");
+                            Property &pinliers=p.addGroup("inliers_thresh");
+                            for(int i=0;i<joint_list.size();i++)
+                            {
+                                pjoint.put("joint_"+to_string(i),joint_list[i]);
+                                pr.put("radius_"+to_string(i),radius[i]);
+                                pscore.put("zscore_thresh_"+to_string(i),zscore[i]);
+                                pinliers.put("inliers_thresh_"+to_string(i),inliers[i]);
+                            }
+                        }
+                        exercise->setFeedbackParams(feedparams);
+                    }
+                    //add the exercise to the repertoire
+                    exercises.insert(pair<string,Exercise*>(ex_tag,exercise));
+                    exercise->print();
+                }
+            }
+        }
+    }
+    else
+    {
+        yError() << "Error in loading the motion repertoire from" << from;
+        return false;
+    }
+
+    return true;
+}
+
+/********************************************************/
+Exercise* Repertoire::get(const string &exercise_tag) const
+{
+    auto it=exercises.find(exercise_tag);
+    return (it!=exercises.end()?it->second:NULL);
+}
+
+/********************************************************/
+vector<string> Repertoire::list() const
+{
+    vector<string> tags;
+    for(auto &it:exercises)
+    {
+        tags.push_back(it.first);
+    }
+    return tags;
+}
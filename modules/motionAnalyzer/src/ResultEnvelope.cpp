@@ -0,0 +1,61 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file ResultEnvelope.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include <algorithm>
+
+#include "ResultEnvelope.h"
+
+using namespace std;
+using namespace yarp::os;
+
+/********************************************************/
+ResultEnvelope::ResultEnvelope() : n(0), restart(true)
+{
+
+}
+
+/********************************************************/
+void ResultEnvelope::update(const vector<Processor*> &processors, const bool valid)
+{
+    size_t len=0;
+    for(auto &processor:processors)
+    {
+        len+=processor->getValues().size();
+    }
+    if(len!=n)
+    {
+        n=len;
+        packed.assign(3*n,0.0);
+        restart=true;
+    }
+
+    //values are laid out as last, min, max
+    size_t k=0;
+    for(auto &processor:processors)
+    {
+        for(auto &v:processor->getValues())
+        {
+            double val=valid?v:0.0;
+            packed[k]=val;
+            packed[n+k]=restart?val:std::min(packed[n+k],val);
+            packed[2*n+k]=restart?val:std::max(packed[2*n+k],val);
+            k++;
+        }
+    }
+    restart=false;
+}
+
+/********************************************************/
+void ResultEnvelope::write(Bottle &b) const
+{
+    b.add(Value::makeBlob((void*)packed.data(),(int)(packed.size()*sizeof(double))));
+}
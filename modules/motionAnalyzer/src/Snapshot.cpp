@@ -0,0 +1,46 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file Snapshot.cpp
+ * @authors: Valentina Vasco <valentina.vasco@iit.it>
+ */
+
+#include "Snapshot.h"
+
+using namespace std;
+using namespace yarp::sig;
+using namespace assistive_rehab;
+
+/********************************************************/
+SkeletonFrame::SkeletonFrame(const Skeleton &skeleton)
+{
+    //only updated keypoints are copied, the others stay stale
+    vector<pair<string,Vector>> unordered;
+    for(unsigned int i=0; i<skeleton.getNumKeyPoints(); i++)
+    {
+        const KeyPoint* k=skeleton[i];
+        if(k->isUpdated())
+        {
+            unordered.push_back(make_pair(k->getTag(),k->getPoint()));
+        }
+    }
+
+    raw.setTag(skeleton.getTag());
+    raw.update(unordered);
+
+    normalized.setTag(skeleton.getTag());
+    normalized.update(unordered);
+    normalized.normalize();
+    planes=normalized.update_planes();
+}
+
+/********************************************************/
+SkeletonSnapshot makeSnapshot(const Skeleton &skeleton)
+{
+    return make_shared<const SkeletonFrame>(skeleton);
+}
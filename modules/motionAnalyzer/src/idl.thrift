@@ -38,8 +38,17 @@ service motionAnalyzer_IDL
    */
    list<string> listExercises();
 
+   /**
+   * Parse again the motion-repertoire file, without restarting the module.
+   * The exercise being performed is not affected until it is loaded again.
+   * @return true/false on success/failure, in which case the current repertoire is kept.
+   */
+   bool reloadRepertoire();
+
    /**
    * Start processing.
+   * Skeletons added with addSkel are enough to start even if no skeleton has been selected,
+   * in which case they are analyzed but no feedback is given.
    * @param use_robot_template true if robot template is used.
    * @return true/false on success/failure.
    */
@@ -64,6 +73,33 @@ service motionAnalyzer_IDL
    */
    bool selectSkel(1:string skel_tag);
 
+   /**
+   * Analyze a further skeleton along with the selected one.
+   * Each skeleton is processed whenever it is updated, independently of the others.
+   * @param skel_tag tag of the skeleton to add
+   * @return true/false on success/failure.
+   */
+   bool addSkel(1:string skel_tag);
+
+   /**
+   * Stop analyzing a skeleton added with addSkel.
+   * @param skel_tag tag of the skeleton to remove
+   * @return true/false on success/failure.
+   */
+   bool removeSkel(1:string skel_tag);
+
+   /**
+   * List the analyzed skeletons, in the order their results appear on the scope port.
+   * @return the list of the analyzed skeletons, the selected one first.
+   */
+   list<string> listSkels();
+
+   /**
+   * List the results published on the results port for each skeleton.
+   * @return the list of results, as metric::property, in the order of the published values.
+   */
+   list<string> listResults();
+
    /**
    * List joints on which feedback is computed.
    * @return the list of joints on which feedback is computed.
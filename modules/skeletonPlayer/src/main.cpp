@@ -12,8 +12,10 @@
 
 #include <cstdlib>
 #include <mutex>
+#include <atomic>
 #include <memory>
 #include <vector>
+#include <algorithm>
 #include <iterator>
 #include <string>
 #include <fstream>
@@ -23,6 +25,7 @@
 #include <yarp/math/Math.h>
 
 #include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/skeletonStream.h"
 #include "src/skeletonPlayer_IDL.h"
 
 using namespace std;
@@ -59,19 +62,34 @@ class Player : public RFModule, public skeletonPlayer_IDL
     double t_origin;
 
     BufferedPort<Bottle> viewerPort;
+    SkeletonStreamEncoder viewerEncoder;
+
+    // any viewer connecting, reconnections included, needs a keyframe straightaway
+    class ViewerReporter : public PortReport {
+        void report(const PortInfo &info) override {
+            if (info.created && !info.incoming)
+                connected=true;
+        }
+    public:
+        atomic<bool> connected{false};
+    } viewerReporter;
     RpcClient opcPort;
     RpcServer cmdPort;
 
     /****************************************************************/
-    void viewerUpdate(Property &prop)
+    void viewerUpdate()
     {
+        if (viewerReporter.connected.exchange(false))
+            viewerEncoder.clear();
+
         if (viewerPort.getOutputCount()>0)
         {
-            prop.put("opacity",opacity);
-            prop.put("color",color.get(0));
+            Property extra;
+            extra.put("opacity",opacity);
+            extra.put("color",color.get(0));
             Bottle &msg=viewerPort.prepare();
             msg.clear();
-            msg.addList().read(prop);
+            viewerEncoder.encode(*it->s,msg,extra);
             viewerPort.writeStrict();
         }
     }
@@ -90,7 +108,7 @@ class Player : public RFModule, public skeletonPlayer_IDL
                 if (rep.get(0).asVocab()==Vocab::encode("ack"))
                 {
                     opc_id=rep.get(1).asList()->get(1).asInt();
-                    viewerUpdate(prop);
+                    viewerUpdate();
                     return true;
                 }
             }
@@ -118,7 +136,7 @@ class Player : public RFModule, public skeletonPlayer_IDL
             {
                 if (rep.get(0).asVocab()==Vocab::encode("ack"))
                 {
-                    viewerUpdate(prop);
+                    viewerUpdate();
                     return true;
                 }
             }
@@ -492,6 +510,7 @@ class Player : public RFModule, public skeletonPlayer_IDL
     bool configure(ResourceFinder &rf) override
     {
         viewerPort.open("/skeletonPlayer/viewer:o");
+        viewerPort.setReporter(viewerReporter);
         opcPort.open("/skeletonPlayer/opc:rpc");
         cmdPort.open("/skeletonPlayer/cmd:rpc");
         attach(cmdPort);
@@ -501,6 +520,9 @@ class Player : public RFModule, public skeletonPlayer_IDL
 
         opacity=0.2;
         color.addList().read(Vector(3,0.7));
+
+        viewerEncoder.setKeyFramePeriod((unsigned int)std::max(rf.check("keyframe-period",Value(30)).asInt(),0));
+        viewerEncoder.setThreshold(rf.check("delta-threshold",Value(0.001)).asDouble());
         return true;
     }
 
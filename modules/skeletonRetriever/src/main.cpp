@@ -12,6 +12,8 @@
 
 #include <cstdlib>
 #include <memory>
+#include <mutex>
+#include <atomic>
 #include <limits>
 #include <algorithm>
 #include <vector>
@@ -19,7 +21,9 @@
 #include <iterator>
 #include <utility>
 #include <sstream>
+#include <fstream>
 #include <iostream>
+#include <iomanip>
 #include <string>
 #include <yarp/os/all.h>
 #include <yarp/dev/PolyDriver.h>
@@ -27,12 +31,16 @@
 #include <yarp/dev/IVisualParams.h>
 #include <yarp/dev/GenericVocabs.h>
 #include <yarp/sig/all.h>
+#include <yarp/sig/ImageFile.h>
 #include <yarp/math/Math.h>
 #include <iCub/ctrl/filters.h>
 #include "AssistiveRehab/helpers.h"
 #include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/profiler.h"
+#include "AssistiveRehab/skeletonStream.h"
 #include "utils.h"
 #include "nlp.h"
+#include "opc.h"
 
 using namespace std;
 using namespace yarp::os;
@@ -43,6 +51,13 @@ using namespace assistive_rehab;
 
 const string unknown_tag("?");
 
+namespace Stage
+{
+enum { depth=0, create, validation, association, update, optimization, opc, opc_rpc, tf, viewer, cycle };
+const vector<string> names={"depth","create","validation","association","update",
+                            "optimization","opc","opc-rpc","tf","viewer","cycle"};
+}
+
 /****************************************************************/
 bool is_unknown(const string &tag)
 {
@@ -58,6 +73,7 @@ class MetaSkeleton
     unordered_map<string,unsigned int> limbs_length_cnt;
     bool optimize_limblength;
     CamParamsHelper camParams;
+    Profiler &profiler;
     
     /****************************************************************/
     vector<pair<string,pair<Vector,Vector>>> optimize_limbs(const vector<string> &tags)
@@ -97,9 +113,9 @@ public:
 
     /****************************************************************/
     MetaSkeleton(const CamParamsHelper &camParams_, const double t, const int filter_keypoint_order_,
-                 const int filter_limblength_order_, const bool optimize_limblength_) : 
+                 const int filter_limblength_order_, const bool optimize_limblength_, Profiler &profiler_) : 
                  camParams(camParams_), timer(t), opc_id(opc_id_invalid),
-                 optimize_limblength(optimize_limblength_), name_confidence(0.0)
+                 optimize_limblength(optimize_limblength_), name_confidence(0.0), profiler(profiler_)
     {
         skeleton=shared_ptr<SkeletonStd>(new SkeletonStd());
         keys_acceptable_misses.assign(skeleton->getNumKeyPoints(),0);
@@ -205,6 +221,7 @@ public:
 
         if (optimize_limblength)
         {
+            ScopedTimer timer(profiler,Stage::optimization);
             vector<pair<string,pair<Vector,Vector>>> tmp;
             tmp=optimize_limbs({KeyPointTag::shoulder_left,KeyPointTag::elbow_left,KeyPointTag::hand_left});
             unordered_filtered.insert(end(unordered_filtered),begin(tmp),end(tmp));
@@ -226,13 +243,29 @@ public:
 
 
 /****************************************************************/
-class Retriever : public RFModule
+class Retriever : public RFModule,
+                  public TypedReaderCallback<Bottle>,
+                  public TypedReaderCallback<ImageOf<PixelFloat>>
 {
     BufferedPort<Bottle> skeletonsPort;
     BufferedPort<ImageOf<PixelFloat>> depthPort;
     BufferedPort<Bottle> viewerPort;
+    BufferedPort<Bottle> statsPort;
+    RpcServer rpcPort;
     RpcClient opcPort;
     RpcClient camPort;
+    shared_ptr<OpcWriter> opcWriter;
+    SkeletonStreamEncoder viewerEncoder;
+
+    // any viewer connecting, reconnections included, needs keyframes straightaway
+    class ViewerReporter : public PortReport {
+        void report(const PortInfo &info) override {
+            if (info.created && !info.incoming)
+                connected=true;
+        }
+    public:
+        atomic<bool> connected{false};
+    } viewerReporter;
     yarp::dev::PolyDriver tcpolydriver;
     yarp::dev::IFrameTransform* iTf = nullptr;
 
@@ -245,7 +278,9 @@ class Retriever : public RFModule
     unordered_map<string,string> keysRemap;
     vector<shared_ptr<MetaSkeleton>> skeletons;
 
+    mutex mtx;
     bool camera_configured;
+    bool event_driven;
     double period;
     double fov_h;
     double fov_v;
@@ -265,7 +300,11 @@ class Retriever : public RFModule
     int filter_keypoint_order;
     int filter_limblength_order;
     bool optimize_limblength;
-    double t0;
+    int opc_queue_size;
+    double stats_period;
+    double t0,t_stats;
+
+    Profiler profiler{Stage::names};
 
     /****************************************************************/
     bool getCameraOptions()
@@ -328,7 +367,7 @@ class Retriever : public RFModule
     {
         shared_ptr<MetaSkeleton> s(new MetaSkeleton(CamParamsHelper(depth.width(),depth.height(),fov_h),
                                                     time_to_live,filter_keypoint_order,filter_limblength_order,
-                                                    optimize_limblength));
+                                                    optimize_limblength,profiler));
         vector<pair<string,pair<Vector,Vector>>> unordered;
         auto foot_left=make_pair(string(""),make_pair(Vector(1),Vector(1)));
         auto foot_right=foot_left;
@@ -525,28 +564,21 @@ class Retriever : public RFModule
     /****************************************************************/
     bool opcAdd(shared_ptr<MetaSkeleton> &s, const Stamp &stamp)
     {
-        if (opcPort.getOutputCount())
+        if (opcWriter->isConnected())
         {
-            Bottle cmd,rep;
-            cmd.addVocab(Vocab::encode("add"));
             Property prop=applyTransform(s->skeleton)->toProperty();
             if (stamp.isValid())
             {
                 prop.put("stamp",stamp.getTime());
             }
-            cmd.addList().read(prop);
-            if (opcPort.write(cmd,rep))
+            if (opcWriter->add(prop,s->opc_id))
             {
-                if (rep.get(0).asVocab()==Vocab::encode("ack"))
+                if (is_unknown(s->skeleton->getTag()))
                 {
-                    s->opc_id=rep.get(1).asList()->get(1).asInt();
-                    if (is_unknown(s->skeleton->getTag()))
-                    {
-                        s->skeleton->setTag(getNameFromId(s->opc_id));
-                        return opcSet(s,stamp);
-                    }
-                    return true;
+                    s->skeleton->setTag(getNameFromId(s->opc_id));
+                    return opcSet(s,stamp);
                 }
+                return true;
             }
         }
 
@@ -579,26 +611,15 @@ class Retriever : public RFModule
     /****************************************************************/
     bool opcSet(const shared_ptr<MetaSkeleton> &s, const Stamp &stamp)
     {
-        if (opcPort.getOutputCount())
+        if (opcWriter->isConnected())
         {
-            Bottle cmd,rep;
-            cmd.addVocab(Vocab::encode("set"));
-            Bottle &pl=cmd.addList();
             Property prop=applyTransform(s->skeleton)->toProperty();
             if (stamp.isValid())
             {
                 prop.put("stamp",stamp.getTime());
             }
-            pl.read(prop);
-            Bottle id;
-            Bottle &id_pl=id.addList();
-            id_pl.addString("id");
-            id_pl.addInt(s->opc_id);
-            pl.append(id);
-            if (opcPort.write(cmd,rep))
-            {
-                return (rep.get(0).asVocab()==Vocab::encode("ack"));
-            }
+            opcWriter->set(s->opc_id,prop);
+            return true;
         }
 
         return false;
@@ -607,17 +628,10 @@ class Retriever : public RFModule
     /****************************************************************/
     bool opcDel(const shared_ptr<MetaSkeleton> &s)
     {
-        if (opcPort.getOutputCount())
+        if (opcWriter->isConnected())
         {
-            Bottle cmd,rep;
-            cmd.addVocab(Vocab::encode("del"));
-            Bottle &pl=cmd.addList().addList();
-            pl.addString("id");
-            pl.addInt(s->opc_id);
-            if (opcPort.write(cmd,rep))
-            {
-                return (rep.get(0).asVocab()==Vocab::encode("ack"));
-            }
+            opcWriter->del(s->opc_id);
+            return true;
         }
 
         return false;
@@ -717,15 +731,22 @@ class Retriever : public RFModule
     /****************************************************************/
     void viewerUpdate(const vector<string> &remove_tags)
     {
+        if (viewerReporter.connected.exchange(false))
+            viewerEncoder.clear();
+
         if (viewerPort.getOutputCount()>0)
         {
+            // keypoints are transformed while encoded, skeletons are copied only for keyframes
+            viewerEncoder.setTransformation(rootFrame);
             Bottle &msg=viewerPort.prepare();
             msg.clear();
+            vector<string> tags;
             for (auto &s:skeletons)
             {
-                Property prop=applyTransform(s->skeleton)->toProperty();
-                msg.addList().read(prop);
+                viewerEncoder.encode(*s->skeleton,msg);
+                tags.push_back(s->skeleton->getTag());
             }
+            viewerEncoder.retain(tags);
 
             if (!remove_tags.empty())
             {
@@ -744,7 +765,7 @@ class Retriever : public RFModule
     }
 
     /****************************************************************/
-    bool configure(ResourceFinder &rf) override
+    bool configureParams(ResourceFinder &rf)
     {
         keysRemap["Nose"]=KeyPointTag::head;
         keysRemap["Neck"]=KeyPointTag::shoulder_center;
@@ -768,6 +789,7 @@ class Retriever : public RFModule
 
         // default values
         camera_configured=false;
+        event_driven=false;
         period=0.01;
         keys_recognition_confidence=0.3;
         keys_recognition_percentage=0.3;
@@ -783,12 +805,24 @@ class Retriever : public RFModule
         filter_keypoint_order=3;
         filter_limblength_order=40;
         optimize_limblength=true;
+        opc_queue_size=32;
+        stats_period=1.0;
+        int viewer_keyframe_period=30;
+        double viewer_delta_threshold=0.001;
 
         // retrieve values from config file
         Bottle &gGeneral=rf.findGroup("general");
         if (!gGeneral.isNull())
         {
             period=gGeneral.check("period",Value(period)).asDouble();
+            stats_period=gGeneral.check("stats-period",Value(stats_period)).asDouble();
+            string mode=gGeneral.check("mode",Value("polling")).asString();
+            if ((mode!="polling") && (mode!="event-driven"))
+            {
+                yError()<<"Unrecognized processing mode"<<mode;
+                return false;
+            }
+            event_driven=(mode=="event-driven");
         }
 
         Bottle &gSkeleton=rf.findGroup("skeleton");
@@ -820,6 +854,21 @@ class Retriever : public RFModule
             optimize_limblength=gFiltering.check("optimize-limblength",Value(optimize_limblength)).asBool();
         }
 
+        Bottle &gOpc=rf.findGroup("opc");
+        if (!gOpc.isNull())
+        {
+            opc_queue_size=gOpc.check("queue-size",Value(opc_queue_size)).asInt();
+        }
+
+        Bottle &gViewer=rf.findGroup("viewer");
+        if (!gViewer.isNull())
+        {
+            viewer_keyframe_period=gViewer.check("keyframe-period",Value(viewer_keyframe_period)).asInt();
+            viewer_delta_threshold=gViewer.check("delta-threshold",Value(viewer_delta_threshold)).asDouble();
+        }
+        viewerEncoder.setKeyFramePeriod((unsigned int)std::max(viewer_keyframe_period,0));
+        viewerEncoder.setThreshold(viewer_delta_threshold);
+
         Bottle &gCamera=rf.findGroup("camera");
         if (!gCamera.isNull())
         {
@@ -839,12 +888,96 @@ class Retriever : public RFModule
             }
         }
 
+        rootFrame=eye(4,4);
+        return true;
+    }
+
+    /****************************************************************/
+    bool loadLog(const string &dir, vector<pair<double,Bottle>> &log) const
+    {
+        // yarpdatadumper line: seq time [time] payload
+        ifstream fin(dir+"/data.log");
+        if (!fin.is_open())
+        {
+            yError()<<"Unable to open"<<dir+"/data.log";
+            return false;
+        }
+
+        for (string line; getline(fin,line);)
+        {
+            Bottle bottle(line);
+            if ((bottle.size()<3) || !bottle.get(1).isDouble())
+            {
+                continue;
+            }
+
+            int i=2;
+            double t=bottle.get(1).asDouble();
+            if (bottle.get(i).isDouble())
+            {
+                // prefer the sender's envelope, if dumped
+                t=bottle.get(i++).asDouble();
+            }
+
+            Bottle payload;
+            for (; i<bottle.size(); i++)
+            {
+                payload.add(bottle.get(i));
+            }
+            log.push_back(make_pair(t,payload));
+        }
+        fin.close();
+
+        return true;
+    }
+
+    /****************************************************************/
+    void writeSkeletons(ofstream &fout, const int frame, const double t)
+    {
+        // same format used by skeletonPlayer
+        fout<<fixed<<setprecision(6);
+        if (skeletons.empty())
+        {
+            fout<<frame<<" "<<t<<" "<<unknown_tag<<" empty"<<endl;
+        }
+        for (auto &s:skeletons)
+        {
+            Property prop=applyTransform(s->skeleton)->toProperty();
+            Bottle b;
+            b.addList().read(prop);
+            fout<<frame<<" "<<t<<" "<<s->skeleton->getTag()<<" "<<b.toString()<<endl;
+        }
+    }
+
+    /****************************************************************/
+    bool configure(ResourceFinder &rf) override
+    {
+        if (!configureParams(rf))
+        {
+            return false;
+        }
+
         skeletonsPort.open("/skeletonRetriever/skeletons:i");
         depthPort.open("/skeletonRetriever/depth:i");
         viewerPort.open("/skeletonRetriever/viewer:o");
+        viewerPort.setReporter(viewerReporter);
+        statsPort.open("/skeletonRetriever/stats:o");
+        rpcPort.open("/skeletonRetriever/rpc");
+        attach(rpcPort);
         opcPort.open("/skeletonRetriever/opc:rpc");
         camPort.open("/skeletonRetriever/cam:rpc");
 
+        opcWriter=shared_ptr<OpcWriter>(new OpcWriter(&opcPort,(size_t)std::max(opc_queue_size,1),
+                                                      profiler,Stage::opc_rpc));
+        opcWriter->start();
+
+        if (event_driven)
+        {
+            yInfo()<<"Processing skeletons as they arrive";
+            depthPort.useCallback(*this);
+            skeletonsPort.useCallback(*this);
+        }
+
         Bottle &tc_cfg = rf.findGroup("transformClient");
         rootFrameName = tc_cfg.find("rootFrameName").asString();
         string tcClientLocalName = "/skeletonRetriever/TfClient";
@@ -874,9 +1007,7 @@ class Retriever : public RFModule
             }
         }
 
-        rootFrame=eye(4,4);
-
-        t0=Time::now();
+        t0=t_stats=Time::now();
         return true;
     }
 
@@ -887,115 +1018,345 @@ class Retriever : public RFModule
     }
 
     /****************************************************************/
-    bool updateModule() override
+    Bottle getStats()
     {
-        const double t=Time::now();
-        const double dt=t-t0;
-        t0=t;
-
-        if (ImageOf<PixelFloat> *depth=depthPort.read(false))
+        // durations are expressed in ms
+        Bottle stats;
+        for (auto &s:profiler.getStats())
         {
-            if (depth_enable)
-            {
-                filterDepth(*depth,this->depth,depth_kernel_size,depth_iterations,
-                            depth_min_distance,depth_max_distance);
-            }
-            else
-            {
-                this->depth=*depth;
-            }
+            Bottle &b=stats.addList();
+            b.addString(s.name);
+            Bottle &count=b.addList();
+            count.addString("count");
+            count.addInt((int)s.count);
+            Bottle &p50=b.addList();
+            p50.addString("p50");
+            p50.addDouble(1e3*s.p50);
+            Bottle &p95=b.addList();
+            p95.addString("p95");
+            p95.addDouble(1e3*s.p95);
+            Bottle &p99=b.addList();
+            p99.addString("p99");
+            p99.addDouble(1e3*s.p99);
         }
+        return stats;
+    }
 
-        if (!camera_configured)
+    /****************************************************************/
+    bool respond(const Bottle &command, Bottle &reply) override
+    {
+        string cmd=command.get(0).asString();
+        if (cmd=="stats")
         {
-            camera_configured=getCameraOptions();
+            reply.addVocab(Vocab::encode("ok"));
+            reply.append(getStats());
+            return true;
+        }
+        else if (cmd=="reset")
+        {
+            profiler.reset();
+            reply.addVocab(Vocab::encode("ok"));
+            return true;
         }
+        return RFModule::respond(command,reply);
+    }
 
-        // garbage collector
-        gc(dt);
+    /****************************************************************/
+    void processDepth(const ImageOf<PixelFloat> &depth)
+    {
+        ScopedTimer timer(profiler,Stage::depth);
+        if (depth_enable)
+        {
+            filterDepth(depth,this->depth,depth_kernel_size,depth_iterations,
+                        depth_min_distance,depth_max_distance);
+        }
+        else
+        {
+            this->depth=depth;
+        }
+    }
 
-        // handle skeletons acquired from detector
-        if (Bottle *b1=skeletonsPort.read(false))
+    /****************************************************************/
+    void processSkeletons(const Bottle &b1, const Stamp &stamp)
+    {
+        ScopedTimer timer(profiler,Stage::cycle);
+        if (Bottle *b2=b1.get(0).asList())
         {
-            if (Bottle *b2=b1->get(0).asList())
-            {
-                // acquire skeletons with sufficient number of key-points
-                vector<shared_ptr<MetaSkeleton>> new_accepted_skeletons;
+            // acquire skeletons with sufficient number of key-points
+            vector<shared_ptr<MetaSkeleton>> new_accepted_skeletons;
 
-                for (size_t i=0; i<b2->size(); i++)
+            for (size_t i=0; i<b2->size(); i++)
+            {
+                Bottle *b3=b2->get(i).asList();
+                if ((depth.width()>0) && (depth.height()>0) && (b3!=nullptr))
                 {
-                    Bottle *b3=b2->get(i).asList();
-                    if ((depth.width()>0) && (depth.height()>0) && (b3!=nullptr))
+                    shared_ptr<MetaSkeleton> s;
                     {
-                        shared_ptr<MetaSkeleton> s=create(b3);
-                        if (isValid(s))
-                        {
-                            new_accepted_skeletons.push_back(s);
-                        }
+                        ScopedTimer timer(profiler,Stage::create);
+                        s=create(b3);
+                    }
+                    bool valid;
+                    {
+                        ScopedTimer timer(profiler,Stage::validation);
+                        valid=isValid(s);
+                    }
+                    if (valid)
+                    {
+                        new_accepted_skeletons.push_back(s);
                     }
                 }
+            }
 
-                // update existing skeletons / create new skeletons
-                if (!new_accepted_skeletons.empty())
-                {
-                    Stamp stamp;
-                    skeletonsPort.getEnvelope(stamp);
-
-                    enforce_tag_uniqueness_input(new_accepted_skeletons);
+            // update existing skeletons / create new skeletons
+            if (!new_accepted_skeletons.empty())
+            {
+                enforce_tag_uniqueness_input(new_accepted_skeletons);
 
-                    vector<string> viewer_remove_tags;
-                    vector<shared_ptr<MetaSkeleton>> pending=skeletons;
-                    int counter = 0;
-                    for (auto &n:new_accepted_skeletons)
+                vector<string> viewer_remove_tags;
+                vector<shared_ptr<MetaSkeleton>> pending=skeletons;
+                int counter = 0;
+                for (auto &n:new_accepted_skeletons)
+                {
+                    string skeleton_frame_prefix = "/human" + std::to_string(counter++);
+                    vector<double> scores;
+                    vector<double>::iterator it;
                     {
-                        string skeleton_frame_prefix = "/human" + std::to_string(counter++);
-                        vector<double> scores=computeScores(pending,n);
-                        auto it=min_element(scores.begin(),scores.end());
-                        
-                        yDebug() << "scores size: " << scores.size();
+                        ScopedTimer timer(profiler,Stage::association);
+                        scores=computeScores(pending,n);
+                        it=min_element(scores.begin(),scores.end());
+                    }
+                    
+                    yDebug() << "scores size: " << scores.size();
 
-                        if (it!=scores.end())
+                    if (it!=scores.end())
+                    {
+                        if (*it < numeric_limits<double>::infinity())
                         {
-                            if (*it < numeric_limits<double>::infinity())
+                            auto i=distance(scores.begin(),it);
+                            auto &s=pending[i];
                             {
-                                auto i=distance(scores.begin(),it);
-                                auto &s=pending[i];
+                                ScopedTimer timer(profiler,Stage::update);
                                 update(n,s,viewer_remove_tags);
+                            }
+                            {
+                                ScopedTimer timer(profiler,Stage::opc);
                                 opcSet(s,stamp);
-                                pending.erase(pending.begin()+i);
-                                continue;
                             }
+                            pending.erase(pending.begin()+i);
+                            continue;
                         }
+                    }
 
-                        if (opcAdd(n,stamp))
-                        {
-                            skeletons.push_back(n);
-                        }
+                    bool added;
+                    {
+                        ScopedTimer timer(profiler,Stage::opc);
+                        added=opcAdd(n,stamp);
+                    }
+                    if (added)
+                    {
+                        skeletons.push_back(n);
+                    }
+                    {
+                        ScopedTimer timer(profiler,Stage::tf);
                         tfUpdate(n, skeleton_frame_prefix, stamp);
                     }
+                }
 
-                    enforce_tag_uniqueness_pending(pending);
+                enforce_tag_uniqueness_pending(pending);
+                {
+                    ScopedTimer timer(profiler,Stage::viewer);
                     viewerUpdate(viewer_remove_tags);
                 }
             }
         }
 
+        // hand over OPC updates to the writer
+        opcWriter->commit();
+    }
+
+    /****************************************************************/
+    void onRead(ImageOf<PixelFloat> &depth) override
+    {
+        // in event-driven mode, depth only refreshes the buffer
+        lock_guard<mutex> lg(mtx);
+        processDepth(depth);
+    }
+
+    /****************************************************************/
+    void onRead(Bottle &detections) override
+    {
+        // in event-driven mode, skeletons are processed upon arrival
+        lock_guard<mutex> lg(mtx);
+        Stamp stamp;
+        skeletonsPort.getEnvelope(stamp);
+        processSkeletons(detections,stamp);
+    }
+
+    /****************************************************************/
+    bool updateModule() override
+    {
+        lock_guard<mutex> lg(mtx);
+
+        const double t=Time::now();
+        const double dt=t-t0;
+        t0=t;
+
+        if (!event_driven)
+        {
+            if (ImageOf<PixelFloat> *depth=depthPort.read(false))
+            {
+                processDepth(*depth);
+            }
+        }
+
+        if (!camera_configured)
+        {
+            camera_configured=getCameraOptions();
+        }
+
+        // garbage collector
+        gc(dt);
+
+        // handle skeletons acquired from detector
+        if (!event_driven)
+        {
+            if (Bottle *b1=skeletonsPort.read(false))
+            {
+                Stamp stamp;
+                skeletonsPort.getEnvelope(stamp);
+                processSkeletons(*b1,stamp);
+            }
+        }
+
+        // hand over OPC deletions issued by the garbage collector
+        opcWriter->commit();
+
+        if ((statsPort.getOutputCount()>0) && (t-t_stats>=stats_period))
+        {
+            Bottle &stats=statsPort.prepare();
+            stats=getStats();
+            statsPort.writeStrict();
+            t_stats=t;
+        }
         return true;
     }
 
     /****************************************************************/
     bool close() override
     {
-        // remove all skeletons from OPC
-        gc(numeric_limits<double>::infinity());
-
+        // stop callbacks before cleaning up
         skeletonsPort.close();
         depthPort.close();
+
+        // remove all skeletons from OPC
+        if (opcWriter)
+        {
+            lock_guard<mutex> lg(mtx);
+            gc(numeric_limits<double>::infinity());
+            opcWriter->commit();
+            opcWriter->stop();
+        }
+
         viewerPort.close();
+        statsPort.close();
+        rpcPort.close();
         opcPort.close();
         camPort.close();
         if (tcpolydriver.isValid()) { tcpolydriver.close(); }
 
+        return true;
+    }
+
+public:
+    /****************************************************************/
+    bool replay(ResourceFinder &rf)
+    {
+        if (!configureParams(rf))
+        {
+            return false;
+        }
+
+        if (!camera_configured)
+        {
+            yError()<<"Replay requires camera::fov to be specified";
+            return false;
+        }
+
+        string skeletons_log=rf.check("skeletons-log",Value("")).asString();
+        string depth_log=rf.check("depth-log",Value("")).asString();
+        string output=rf.check("output",Value("skeletons.log")).asString();
+        if (skeletons_log.empty() || depth_log.empty())
+        {
+            yError()<<"Replay requires --skeletons-log and --depth-log";
+            return false;
+        }
+
+        vector<pair<double,Bottle>> skeletons_data,depth_data;
+        if (!loadLog(skeletons_log,skeletons_data) || !loadLog(depth_log,depth_data))
+        {
+            return false;
+        }
+        yInfo()<<"Replaying"<<skeletons_data.size()<<"skeletons frames and"
+               <<depth_data.size()<<"depth frames";
+
+        ofstream fout(output);
+        if (!fout.is_open())
+        {
+            yError()<<"Unable to open"<<output;
+            return false;
+        }
+
+        // OPC and viewer are stubbed out, while the TF is not connected
+        opcWriter=shared_ptr<OpcWriter>(new OpcWriter(nullptr,(size_t)std::max(opc_queue_size,1),
+                                                      profiler,Stage::opc_rpc));
+        profiler.reset();
+
+        const double T0=Time::now();
+        size_t j=0;
+        double t_prev=(skeletons_data.empty()?0.0:skeletons_data.front().first);
+        for (size_t i=0; i<skeletons_data.size(); i++)
+        {
+            const double t=skeletons_data[i].first;
+
+            // pair with the latest depth frame not younger than the skeletons
+            size_t k=j;
+            while ((k<depth_data.size()) && (depth_data[k].first<=t))
+            {
+                k++;
+            }
+            if (k>j)
+            {
+                string file=depth_log+"/"+depth_data[k-1].second.get(0).asString();
+                ImageOf<PixelFloat> depth;
+                if (yarp::sig::file::read(depth,file))
+                {
+                    processDepth(depth);
+                }
+                else
+                {
+                    yWarning()<<"Unable to read"<<file;
+                }
+                j=k;
+            }
+
+            gc(t-t_prev);
+            t_prev=t;
+
+            processSkeletons(skeletons_data[i].second,Stamp((int)i,t));
+            writeSkeletons(fout,(int)i,t);
+        }
+        fout.close();
+
+        const double dt=Time::now()-T0;
+        yInfo()<<"Processed"<<skeletons_data.size()<<"frames in"<<dt<<"[s] ="
+               <<(dt>0.0?skeletons_data.size()/dt:0.0)<<"[fps]";
+        for (auto &s:profiler.getStats())
+        {
+            yInfo()<<s.name<<": count ="<<s.count<<"p50 ="<<1e3*s.p50
+                   <<"p95 ="<<1e3*s.p95<<"p99 ="<<1e3*s.p99<<"[ms]";
+        }
+        yInfo()<<"Skeletons stream written to"<<output;
+
         return true;
     }
 };
@@ -1004,6 +1365,21 @@ class Retriever : public RFModule
 /****************************************************************/
 int main(int argc, char *argv[])
 {
+    ResourceFinder rf;
+    rf.setDefaultContext("skeletonRetriever");
+    rf.setDefaultConfigFile("config.ini");
+    rf.configure(argc,argv);
+
+    Retriever retriever;
+    if (rf.check("replay"))
+    {
+        // offline processing does not need the network
+        Network::init();
+        bool ok=retriever.replay(rf);
+        Network::fini();
+        return (ok?EXIT_SUCCESS:EXIT_FAILURE);
+    }
+
     Network yarp;
     if (!yarp.checkNetwork())
     {
@@ -1011,12 +1387,6 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    ResourceFinder rf;
-    rf.setDefaultContext("skeletonRetriever");
-    rf.setDefaultConfigFile("config.ini");
-    rf.configure(argc,argv);
-
-    Retriever retriever;
     return retriever.runModule(rf);
 }
 
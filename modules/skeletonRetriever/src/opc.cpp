@@ -0,0 +1,229 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file opc.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <iterator>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Vocab.h>
+#include "opc.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace assistive_rehab;
+
+
+/****************************************************************/
+OpcWriter::OpcWriter(RpcClient *opcPort_, const size_t queue_size_,
+                     Profiler &profiler_, const size_t stage_) :
+                     opcPort(opcPort_), profiler(profiler_), stage(stage_),
+                     queue_size(queue_size_), frame(0), dropped(0), stub_id(0)
+{
+}
+
+
+/****************************************************************/
+bool OpcWriter::isConnected() const
+{
+    // without a port, the OPC is stubbed out
+    return (isStub() || (opcPort->getOutputCount()>0));
+}
+
+
+/****************************************************************/
+bool OpcWriter::rpc(const Bottle &cmd, Bottle &rep)
+{
+    // the round trip is what the stats report as the OPC latency
+    ScopedTimer timer(profiler,stage);
+    return opcPort->write(cmd,rep);
+}
+
+
+/****************************************************************/
+bool OpcWriter::write(const int id, const Request &req)
+{
+    lock_guard<mutex> lg(port_mtx);
+    if (isStub())
+    {
+        return true;
+    }
+    else if (opcPort->getOutputCount()>0)
+    {
+        Bottle cmd,rep;
+        if (req.del)
+        {
+            cmd.addVocab(Vocab::encode("del"));
+            Bottle &pl=cmd.addList().addList();
+            pl.addString("id");
+            pl.addInt(id);
+        }
+        else
+        {
+            cmd.addVocab(Vocab::encode("set"));
+            Bottle &pl=cmd.addList();
+            pl.read(req.prop);
+            Bottle id_;
+            Bottle &id_pl=id_.addList();
+            id_pl.addString("id");
+            id_pl.addInt(id);
+            pl.append(id_);
+        }
+        if (rpc(cmd,rep))
+        {
+            return (rep.get(0).asVocab()==Vocab::encode("ack"));
+        }
+    }
+
+    return false;
+}
+
+
+/****************************************************************/
+void OpcWriter::onStop()
+{
+    {
+        lock_guard<mutex> lg(mtx);
+    }
+    cv_pending.notify_all();
+}
+
+
+/****************************************************************/
+bool OpcWriter::add(const Property &prop, int &id)
+{
+    // the id is assigned by the OPC, hence "add" is kept synchronous
+    lock_guard<mutex> lg(port_mtx);
+    if (isStub())
+    {
+        id=stub_id++;
+        return true;
+    }
+    else if (opcPort->getOutputCount()>0)
+    {
+        Bottle cmd,rep;
+        cmd.addVocab(Vocab::encode("add"));
+        cmd.addList().read(prop);
+        if (rpc(cmd,rep))
+        {
+            if (rep.get(0).asVocab()==Vocab::encode("ack"))
+            {
+                id=rep.get(1).asList()->get(1).asInt();
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+/****************************************************************/
+void OpcWriter::set(const int id, const Property &prop)
+{
+    auto it=staged.find(id);
+    if ((it==end(staged)) || !it->second.del)
+    {
+        Request &req=staged[id];
+        req.del=false;
+        req.prop=prop;
+    }
+}
+
+
+/****************************************************************/
+void OpcWriter::del(const int id)
+{
+    Request &req=staged[id];
+    req.del=true;
+    req.prop.clear();
+}
+
+
+/****************************************************************/
+void OpcWriter::commit()
+{
+    if (isStub())
+    {
+        staged.clear();
+    }
+    else if (!staged.empty())
+    {
+        {
+            lock_guard<mutex> lg(mtx);
+            for (auto &it:staged)
+            {
+                // latest value wins
+                it.second.frame=frame;
+                pending[it.first]=it.second;
+            }
+
+            // under backpressure, drop the stalest updates
+            // while deletions are always retained
+            while (pending.size()>queue_size)
+            {
+                auto stalest=end(pending);
+                for (auto it=begin(pending); it!=end(pending); it++)
+                {
+                    if (!it->second.del && ((stalest==end(pending)) ||
+                                            (it->second.frame<stalest->second.frame)))
+                    {
+                        stalest=it;
+                    }
+                }
+                if (stalest==end(pending))
+                {
+                    break;
+                }
+                pending.erase(stalest);
+                dropped++;
+            }
+        }
+
+        staged.clear();
+        cv_pending.notify_one();
+    }
+
+    frame++;
+}
+
+
+/****************************************************************/
+unsigned long OpcWriter::getDropped()
+{
+    lock_guard<mutex> lg(mtx);
+    return dropped;
+}
+
+
+/****************************************************************/
+void OpcWriter::run()
+{
+    while (true)
+    {
+        map<int,Request> batch;
+        {
+            unique_lock<mutex> lck(mtx);
+            cv_pending.wait(lck,[this]() { return (!pending.empty() || isStopping()); });
+
+            // drain what is left before quitting
+            if (pending.empty())
+            {
+                break;
+            }
+            batch.swap(pending);
+        }
+
+        for (auto &it:batch)
+        {
+            write(it.first,it.second);
+        }
+    }
+}
+
@@ -0,0 +1,71 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file opc.h
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#ifndef OPC_H
+#define OPC_H
+
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <yarp/os/Thread.h>
+#include <yarp/os/RpcClient.h>
+#include <yarp/os/Property.h>
+#include "AssistiveRehab/profiler.h"
+
+
+/****************************************************************/
+class OpcWriter : public yarp::os::Thread
+{
+    /****************************************************************/
+    struct Request
+    {
+        bool del;
+        yarp::os::Property prop;
+        unsigned long frame;
+    };
+
+    yarp::os::RpcClient *opcPort;
+    assistive_rehab::Profiler &profiler;
+    size_t stage;
+    std::mutex port_mtx;
+    std::mutex mtx;
+    std::condition_variable cv_pending;
+
+    std::map<int,Request> staged;
+    std::map<int,Request> pending;
+    size_t queue_size;
+    unsigned long frame;
+    unsigned long dropped;
+    int stub_id;
+
+    bool rpc(const yarp::os::Bottle &cmd, yarp::os::Bottle &rep);
+    bool write(const int id, const Request &req);
+    void onStop() override;
+
+public:
+    /****************************************************************/
+    OpcWriter(yarp::os::RpcClient *opcPort_, const size_t queue_size_,
+              assistive_rehab::Profiler &profiler_, const size_t stage_);
+
+    /****************************************************************/
+    bool isStub() const { return (opcPort==nullptr); }
+    bool isConnected() const;
+    bool add(const yarp::os::Property &prop, int &id);
+    void set(const int id, const yarp::os::Property &prop);
+    void del(const int id);
+    void commit();
+    unsigned long getDropped();
+    void run() override;
+};
+
+#endif
+
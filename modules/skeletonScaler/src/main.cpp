@@ -13,12 +13,16 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #include <yarp/sig/Vector.h>
 #include <yarp/os/all.h>
 #include <yarp/math/Math.h>
 
 #include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/opcClient.h"
 
 using namespace std;
 using namespace yarp::os;
@@ -28,7 +32,7 @@ using namespace assistive_rehab;
 
 class Scaler : public RFModule
 {
-    RpcClient opcPort;
+    OpcClient opc;
     RpcClient cmdPort;
     RpcClient rpcViewerPort;
     RpcServer rpcPort;
@@ -44,10 +48,28 @@ class Scaler : public RFModule
     string sel_tag;
     string prev_tag;
 
+    //changes of the replica, notified by the opc client
+    mutex mtx_replica;
+    condition_variable cv_replica;
+    unsigned long replica_changes;
+
     /****************************************************************/
     bool configure(ResourceFinder &rf)
     {
-        opcPort.open("/skeletonScaler/opc");
+        if(!opc.open("/skeletonScaler/opc",rf.check("opc-mode",Value("rpc")).asString()))
+        {
+            yError()<<"Unable to open the opc client, check opc-mode";
+            return false;
+        }
+        replica_changes=0;
+        opc.addCallback([this](const vector<string>&)
+        {
+            {
+                lock_guard<mutex> lg(mtx_replica);
+                replica_changes++;
+            }
+            cv_replica.notify_all();
+        });
         cmdPort.open("/skeletonScaler/player:rpc");
         rpcViewerPort.open("/skeletonScaler/viewer:rpc");
         rpcPort.open("/skeletonScaler/rpc");
@@ -191,68 +213,21 @@ class Scaler : public RFModule
     /****************************************************************/
     void getSkeletonsFromOpc(SkeletonStd& skeleton, SkeletonStd& playedSkel)
     {
-        //ask for the property id
-        Bottle cmd, reply;
-        cmd.addVocab(Vocab::encode("ask"));
-        Bottle &content = cmd.addList().addList();
-        content.addString("skeleton");
-        opcPort.write(cmd, reply);
-
-        if(reply.size() > 1)
+        opc.refresh();
+        vector<string> tags=opc.getTags("skeleton");
+        for(auto &tag:tags)
         {
-            if(reply.get(0).asVocab() == Vocab::encode("ack"))
+            if(file.find(tag)==string::npos)
             {
-                if(Bottle *idField = reply.get(1).asList())
+                if(!sel_tag.empty() && tag==sel_tag)
                 {
-                    if(Bottle *idValues = idField->get(1).asList())
-                    {
-                        bool hasUpdated=false;
-                        for(int i=0; i<idValues->size(); i++)
-                        {
-                            int id = idValues->get(i).asInt();
-
-                            //given the id, get the value of the property
-                            cmd.clear();
-                            cmd.addVocab(Vocab::encode("get"));
-                            Bottle &content = cmd.addList().addList();
-                            content.addString("id");
-                            content.addInt(id);
-                            Bottle replyProp;
-                            opcPort.write(cmd, replyProp);
-
-                            if(replyProp.get(0).asVocab() == Vocab::encode("ack"))
-                            {
-                                if(Bottle *propField = replyProp.get(1).asList())
-                                {
-                                    Property prop(propField->toString().c_str());
-                                    string tag=prop.find("tag").asString();
-                                    if(!tag.empty())
-                                    {
-                                        if(prop.check("tag"))
-                                        {
-                                            if(file.find(tag)==string::npos)
-                                            {
-                                                if(!sel_tag.empty() && tag==sel_tag)
-                                                {
-                                                    Skeleton* skel1 = skeleton_factory(prop);
-                                                    skeleton.update(skel1->toProperty());
-                                                    delete skel1;
-                                                }
-                                            }
-                                            else
-                                            {
-                                                Skeleton* skel2 = skeleton_factory(prop);
-                                                playedSkel.update(skel2->toProperty());
-                                                delete skel2;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    opc.getSkeleton(tag,skeleton);
                 }
             }
+            else
+            {
+                opc.getSkeleton(tag,playedSkel);
+            }
         }
     }
 
@@ -381,7 +356,28 @@ class Scaler : public RFModule
 
         SkeletonStd retrievedSkel, playedSkel;
 
+        unsigned long seen;
+        {
+            lock_guard<mutex> lg(mtx_replica);
+            seen=replica_changes;
+        }
         getSkeletonsFromOpc(retrievedSkel,playedSkel);
+
+        //the played skeleton reaches the replica with the next broadcast,
+        //hence the replica is looked at again only when it changes
+        if(opc.isBroadcast())
+        {
+            auto deadline=chrono::steady_clock::now()+chrono::seconds(1);
+            unique_lock<mutex> lck(mtx_replica);
+            while(playedSkel.getTag().empty() &&
+                  cv_replica.wait_until(lck,deadline,[&](){ return (replica_changes!=seen); }))
+            {
+                seen=replica_changes;
+                lck.unlock();
+                getSkeletonsFromOpc(retrievedSkel,playedSkel);
+                lck.lock();
+            }
+        }
         yInfo() << retrievedSkel.getTag() << playedSkel.getTag();
 
         Matrix T;
@@ -490,7 +486,7 @@ class Scaler : public RFModule
     {
        stop();
        hide();
-       opcPort.interrupt();
+       opc.interrupt();
        cmdPort.interrupt();
        rpcViewerPort.interrupt();
 
@@ -500,7 +496,7 @@ class Scaler : public RFModule
     /****************************************************************/
     bool close()
     {
-        opcPort.close();
+        opc.close();
         cmdPort.close();
         rpcViewerPort.close();
 
@@ -50,6 +50,7 @@
 #include <vtkInteractorStyleSwitch.h>
 
 #include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/skeletonStream.h"
 #include "src/skeletonViewer_IDL.h"
 
 using namespace std;
@@ -86,7 +87,7 @@ protected:
     unordered_map<const KeyPoint*,unordered_map<const KeyPoint*,unsigned int>> kk2id_quadric;
 
     /****************************************************************/
-    bool update_color(const Property &p)
+    bool update_color(const Searchable &p)
     {
         if (Bottle *b=p.find("color").asList())
         {
@@ -309,31 +310,54 @@ public:
         vtk_renderer->RemoveActor(vtk_text_actor);
     }
 
+    /****************************************************************/
+    void refresh(const Searchable &prop)
+    {
+        update_color(prop);
+        opacity=prop.check("opacity",Value(1.0)).asDouble();
+
+        if (skeleton->getNumKeyPoints()>0)
+        {
+            update_limbs((*skeleton)[0]);
+
+            Vector p;
+            if (findCaptionPoint(p))
+                vtk_text_actor->SetAttachmentPoint(p.data());
+            vtk_text_actor->GetCaptionTextProperty()->SetColor(color.data());
+            vtk_text_actor->SetVisibility(opacity!=0.0);
+        }
+    }
+
     /****************************************************************/
     void update(const Property &prop)
     {
         if (skeleton!=nullptr)
         {
             skeleton->update(prop);
+            refresh(prop);
+        }
 
-            update_color(prop);
-            opacity=prop.check("opacity",Value(1.0)).asDouble();
-            
-            if (skeleton->getNumKeyPoints()>0)
-            {
-                update_limbs((*skeleton)[0]);
+        last_update=Time::now();
+    }
 
-                Vector p;
-                if (findCaptionPoint(p))
-                    vtk_text_actor->SetAttachmentPoint(p.data());
-                vtk_text_actor->GetCaptionTextProperty()->SetColor(color.data());
-                vtk_text_actor->SetVisibility(opacity!=0.0);
-            }
+    /****************************************************************/
+    void update(const Bottle &delta)
+    {
+        if (skeleton!=nullptr)
+        {
+            if (SkeletonStreamDecoder::decode(delta,*skeleton))
+                refresh(delta);
         }
 
         last_update=Time::now();
     }
 
+    /****************************************************************/
+    void keep_alive()
+    {
+        last_update=Time::now();
+    }
+
     /****************************************************************/
     double get_last_update() const
     {
@@ -415,6 +439,7 @@ bool rpc_camera_rx;
 vector<Bottle> skeletons_rx;
 unordered_map<string,unique_ptr<VTKSkeleton>> skeletons;
 unordered_set<string> skeletons_gc_tags;
+SkeletonStreamDecoder skeletons_decoder;
 
 unordered_set<string> lines_rx;
 unordered_map<string,unique_ptr<VTKLine>> lines;
@@ -470,12 +495,28 @@ public:
                 {
                     if (Bottle *b1=sk.get(i).asList())
                     {
-                        if (b1->check("tag"))
+                        string tag;
+                        if (SkeletonStreamDecoder::isDelta(*b1,tag))
+                        {
+                            // deltas apply only on top of a received keyframe,
+                            // provided that none got lost in between
+                            auto s=skeletons.find(tag);
+                            if (s!=skeletons.end())
+                            {
+                                if (skeletons_decoder.accept(*b1))
+                                    s->second->update(*b1);
+                                else
+                                    s->second->keep_alive();
+                                skeletons_prevent_gc_tags.insert(tag);
+                            }
+                        }
+                        else if (b1->check("tag"))
                         {
                             Property prop(b1->toString().c_str());
                             string tag=prop.find("tag").asString();
                             if (!tag.empty())
                             {
+                                skeletons_decoder.accept(*b1);
                                 auto s=skeletons.find(tag);
                                 if (s==skeletons.end())
                                     skeletons[tag]=unique_ptr<VTKSkeleton>(new VTKSkeleton(prop,vtk_renderer));
@@ -532,6 +573,7 @@ public:
                 auto s=skeletons.find(tag);
                 if (s!=skeletons.end())
                     skeletons.erase(s);
+                skeletons_decoder.remove(tag);
             }
             skeletons_gc_tags.clear();
         }
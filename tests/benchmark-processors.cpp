@@ -0,0 +1,394 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file benchmark-processors.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <random>
+#include <iostream>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Clock.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/profiler.h"
+#include "Metric.h"
+#include "Processor.h"
+#include "Snapshot.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace assistive_rehab;
+
+/****************************************************************/
+// heap accounting through the global operators new/delete,
+// with the size of each block stored in front of it
+namespace
+{
+atomic<uint64_t> num_allocs(0);
+atomic<uint64_t> num_bytes(0);
+atomic<int64_t> live_bytes(0);
+const size_t header=alignof(max_align_t);
+
+void *allocate(size_t size)
+{
+    char *p=static_cast<char*>(malloc(size+header));
+    if (p==nullptr)
+        return nullptr;
+    *reinterpret_cast<size_t*>(p)=size;
+    num_allocs++;
+    num_bytes+=size;
+    live_bytes+=size;
+    return p+header;
+}
+
+void release(void *ptr)
+{
+    if (ptr==nullptr)
+        return;
+    char *p=static_cast<char*>(ptr)-header;
+    live_bytes-=*reinterpret_cast<size_t*>(p);
+    free(p);
+}
+}
+
+void *operator new(size_t size)
+{
+    if (void *p=allocate(size))
+        return p;
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    if (void *p=allocate(size))
+        return p;
+    throw bad_alloc();
+}
+
+void *operator new(size_t size, const nothrow_t&) noexcept { return allocate(size); }
+void *operator new[](size_t size, const nothrow_t&) noexcept { return allocate(size); }
+void operator delete(void *ptr) noexcept { release(ptr); }
+void operator delete[](void *ptr) noexcept { release(ptr); }
+void operator delete(void *ptr, const nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void *ptr, const nothrow_t&) noexcept { release(ptr); }
+#ifdef __cpp_sized_deallocation
+void operator delete(void *ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { release(ptr); }
+#endif
+
+/****************************************************************/
+// processors read the time through yarp, which is driven by the stream
+class StreamClock : public Clock
+{
+public:
+    double t=0.0;
+    double now() override { return t; }
+    void delay(double seconds) override { t+=seconds; }
+    bool isValid() const override { return true; }
+};
+
+/****************************************************************/
+class Stream
+{
+public:
+    virtual ~Stream() { }
+    virtual void reset() = 0;
+    virtual double next(vector<pair<string,Vector>> &keypoints) = 0;
+};
+
+/****************************************************************/
+// left arm abducting at 0.25 Hz while walking on the spot,
+// coordinates in meters with y pointing down as the camera does
+class SyntheticStream : public Stream
+{
+    double dt,t;
+    mt19937 gen;
+    normal_distribution<double> noise;
+
+    void set(vector<pair<string,Vector>> &keypoints, const size_t i,
+             const string &tag, const double x, const double y, const double z)
+    {
+        keypoints[i].first=tag;
+        keypoints[i].second.resize(3);
+        keypoints[i].second[0]=x+noise(gen);
+        keypoints[i].second[1]=y+noise(gen);
+        keypoints[i].second[2]=z+noise(gen);
+    }
+
+public:
+    SyntheticStream(const double fps) : dt(1.0/fps), noise(0.0,0.002) { reset(); }
+
+    void reset() override
+    {
+        t=0.0;
+        gen.seed(0);
+    }
+
+    double next(vector<pair<string,Vector>> &keypoints) override
+    {
+        const double z=2.0;
+        double a=0.25*M_PI*(1.0-cos(2.0*M_PI*t/4.0));
+        double l=0.35*sin(2.0*M_PI*t/1.2);
+
+        keypoints.resize(17);
+        set(keypoints,0,KeyPointTag::shoulder_center,0.0,-0.05,z);
+        set(keypoints,1,KeyPointTag::head,0.0,-0.3,z);
+        set(keypoints,2,KeyPointTag::shoulder_left,0.18,-0.05,z);
+        set(keypoints,3,KeyPointTag::elbow_left,0.18+0.28*sin(a),-0.05+0.28*cos(a),z);
+        set(keypoints,4,KeyPointTag::hand_left,0.18+0.55*sin(a),-0.05+0.55*cos(a),z);
+        set(keypoints,5,KeyPointTag::shoulder_right,-0.18,-0.05,z);
+        set(keypoints,6,KeyPointTag::elbow_right,-0.18,0.23,z);
+        set(keypoints,7,KeyPointTag::hand_right,-0.18,0.5,z);
+        set(keypoints,8,KeyPointTag::hip_center,0.0,0.45,z);
+        set(keypoints,9,KeyPointTag::hip_left,0.1,0.45,z);
+        set(keypoints,10,KeyPointTag::knee_left,0.1,0.45+0.45*cos(l),z-0.45*sin(l));
+        set(keypoints,11,KeyPointTag::ankle_left,0.1,0.45+0.9*cos(l),z-0.9*sin(l));
+        set(keypoints,12,KeyPointTag::foot_left,0.1,0.5+0.9*cos(l),z-0.1-0.9*sin(l));
+        set(keypoints,13,KeyPointTag::hip_right,-0.1,0.45,z);
+        set(keypoints,14,KeyPointTag::knee_right,-0.1,0.45+0.45*cos(l),z+0.45*sin(l));
+        set(keypoints,15,KeyPointTag::ankle_right,-0.1,0.45+0.9*cos(l),z+0.9*sin(l));
+        set(keypoints,16,KeyPointTag::foot_right,-0.1,0.5+0.9*cos(l),z-0.1+0.9*sin(l));
+
+        double curr=t;
+        t+=dt;
+        return curr;
+    }
+};
+
+/****************************************************************/
+// a recorded session played back over and over
+class RecordedStream : public Stream
+{
+    vector<double> times;
+    vector<vector<pair<string,Vector>>> frames;
+    double period,offset;
+    size_t i;
+
+public:
+    bool load(const string &file)
+    {
+        ifstream fin(file);
+        if (!fin.is_open())
+            return false;
+
+        string line;
+        while (getline(fin,line))
+        {
+            Bottle b(line);
+            Bottle *sk=b.get(3).asList();
+            if (sk==nullptr)
+                continue;
+
+            Property prop(sk->toString().c_str());
+            unique_ptr<Skeleton> skeleton(skeleton_factory(prop));
+            if (skeleton==nullptr)
+                continue;
+
+            times.push_back(b.get(1).asDouble());
+            frames.push_back(skeleton->get_unordered());
+        }
+
+        if (times.size()<2)
+            return false;
+
+        // rebase time and loop with the mean sampling period
+        double t0=times.front();
+        for (auto &t:times)
+            t-=t0;
+        period=times.back()+times.back()/(times.size()-1);
+        reset();
+        return true;
+    }
+
+    void reset() override
+    {
+        offset=0.0;
+        i=0;
+    }
+
+    double next(vector<pair<string,Vector>> &keypoints) override
+    {
+        keypoints=frames[i];
+        double t=offset+times[i];
+        if (++i>=frames.size())
+        {
+            i=0;
+            offset+=period;
+        }
+        return t;
+    }
+};
+
+/****************************************************************/
+struct Result
+{
+    string name;
+    uint64_t frames;
+    uint64_t allocs;
+    uint64_t bytes;
+    int64_t growth;
+};
+
+/****************************************************************/
+Result run(Profiler &profiler, const unsigned int stage, const Metric *metric,
+           Stream &stream, StreamClock &clock, const double duration,
+           const double warmup)
+{
+    Result res;
+    res.name=metric->getName();
+    res.frames=0;
+    res.allocs=0;
+    res.bytes=0;
+    res.growth=0;
+
+    stream.reset();
+    vector<pair<string,Vector>> keypoints;
+    SkeletonStd skeleton;
+    clock.t=stream.next(keypoints);
+    skeleton.update(keypoints);
+
+    unique_ptr<Processor> processor(createProcessor(metric));
+    SkeletonSnapshot snapshot=makeSnapshot(skeleton);
+    Matrix T;
+    processor->setInitialConf(snapshot,T);
+
+    int64_t live0=0;
+    bool warm=false;
+    while (clock.t<duration)
+    {
+        clock.t=stream.next(keypoints);
+        skeleton.update(keypoints);
+
+        // the previous snapshot is released outside of the measure
+        SkeletonSnapshot prev=snapshot;
+        auto t0=chrono::steady_clock::now();
+        snapshot=makeSnapshot(skeleton);
+        auto t1=chrono::steady_clock::now();
+
+        uint64_t allocs=num_allocs;
+        uint64_t bytes=num_bytes;
+        auto start=chrono::steady_clock::now();
+        processor->update(snapshot);
+        processor->estimate();
+        auto end=chrono::steady_clock::now();
+        prev.reset();
+
+        if (!warm && (clock.t>=warmup))
+        {
+            live0=live_bytes;
+            warm=true;
+        }
+
+        // as allocations, latencies are accounted only once warm
+        if (warm)
+        {
+            profiler.record(0,chrono::duration_cast<chrono::nanoseconds>(t1-t0).count());
+            profiler.record(stage,chrono::duration_cast<chrono::nanoseconds>(end-start).count());
+            res.allocs+=num_allocs-allocs;
+            res.bytes+=num_bytes-bytes;
+            res.frames++;
+        }
+    }
+
+    res.growth=live_bytes-live0;
+    return res;
+}
+
+/****************************************************************/
+int main(int argc, char *argv[])
+{
+    Property opt;
+    opt.fromCommand(argc,argv);
+    double duration=opt.check("duration",Value(10.0)).asDouble();
+    double fps=opt.check("fps",Value(30.0)).asDouble();
+    double warmup=std::min(opt.check("warmup",Value(1.0)).asDouble(),0.5*duration);
+    int64_t max_growth=opt.check("max-growth",Value(64*1024)).asInt();
+
+    unique_ptr<Stream> stream;
+    if (opt.check("log"))
+    {
+        string file=opt.find("log").asString();
+        unique_ptr<RecordedStream> recorded(new RecordedStream);
+        if (!recorded->load(file))
+        {
+            cerr<<"unable to load "<<file<<endl;
+            return EXIT_FAILURE;
+        }
+        cout<<"### Recorded session "<<file<<", "<<duration<<" s"<<endl;
+        stream=move(recorded);
+    }
+    else
+    {
+        cout<<"### Synthetic session at "<<fps<<" fps, "<<duration<<" s"<<endl;
+        stream.reset(new SyntheticStream(fps));
+    }
+
+    // same parameters as in the motion repertoire
+    Vector down(3,0.0); down[2]=-1.0;
+    Vector num(6),den(6),target(3);
+    num[0]=0.0219; num[1]=0.1097; num[2]=0.2194; num[3]=0.2194; num[4]=0.1097; num[5]=0.0219;
+    den[0]=1.0; den[1]=-0.9853; den[2]=0.9738; den[3]=-0.3864; den[4]=0.1112; den[5]=-0.0113;
+    target[0]=2.0; target[1]=1.0; target[2]=0.0;
+    vector<unique_ptr<Metric>> metrics;
+    metrics.emplace_back(new Rom(MetricType::rom,"ROM_0",KeyPointTag::shoulder_left,"coronal",down,"",0.0,100.0));
+    metrics.emplace_back(new Step(MetricType::step,"step_0",num,den,0.0,2.0));
+    metrics.emplace_back(new EndPoint(MetricType::end_point,"EP_0",KeyPointTag::hand_left,"sagittal",down,0.0,5.0,target));
+
+    vector<string> stages={"snapshot"};
+    for (auto &m:metrics)
+        stages.push_back(m->getName());
+    Profiler profiler(stages);
+
+    StreamClock clock;
+    Time::useCustomClock(&clock);
+
+    vector<Result> results;
+    for (size_t i=0; i<metrics.size(); i++)
+        results.push_back(run(profiler,(unsigned int)(i+1),metrics[i].get(),
+                              *stream,clock,duration,warmup));
+
+    Time::useSystemClock();
+
+    // one line per processor, for regression tracking
+    cout<<"processor frames ns/frame p50(ns) p99(ns) allocs/frame bytes/frame growth(bytes)"<<endl;
+    bool ok=true;
+    for (size_t i=0; i<results.size(); i++)
+    {
+        const Result &r=results[i];
+        StageStats s=profiler.getStats((unsigned int)(i+1));
+        double n=(double)std::max(r.frames,(uint64_t)1);
+        cout<<r.name<<" "<<r.frames<<" "<<1e9*s.mean<<" "<<1e9*s.p50<<" "<<1e9*s.p99<<" "
+            <<r.allocs/n<<" "<<r.bytes/n<<" "<<r.growth<<endl;
+        if (r.growth>max_growth)
+        {
+            cerr<<r.name<<": memory grew by "<<r.growth<<" bytes over the session"<<endl;
+            ok=false;
+        }
+    }
+    StageStats s=profiler.getStats(0);
+    cout<<"snapshot "<<s.count<<" "<<1e9*s.mean<<" "<<1e9*s.p50<<" "<<1e9*s.p99<<endl;
+
+    return (ok?EXIT_SUCCESS:EXIT_FAILURE);
+}
@@ -0,0 +1,203 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file test-estimators.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <random>
+#include <iostream>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/math/Math.h>
+#include <iCub/ctrl/adaptWinPolyEstimator.h>
+#include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/estimators.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+using namespace assistive_rehab;
+
+class JerkEstimator : public AWPolyEstimator
+{
+protected:
+    double getEsteeme() override { return 6.0*coeff[3]; }
+
+public:
+    JerkEstimator(unsigned int N, const double D) : AWPolyEstimator(3,N,D) { }
+};
+
+// minimum-jerk profile from 0 to 1 in T seconds
+void minjerk(const double t, const double T, double &x, double &v, double &j)
+{
+    double tau=std::min(std::max(t/T,0.0),1.0);
+    x=10.0*pow(tau,3)-15.0*pow(tau,4)+6.0*pow(tau,5);
+    v=(30.0*pow(tau,2)-60.0*pow(tau,3)+30.0*pow(tau,4))/T;
+    j=(60.0-360.0*tau+360.0*pow(tau,2))/(T*T*T);
+}
+
+int synthetic()
+{
+    // samples as delivered by the camera: ~30 Hz with jitter and noise
+    mt19937 gen(0);
+    uniform_real_distribution<double> jitter(-0.005,0.005);
+    normal_distribution<double> noise(0.0,0.001);
+
+    DerivativeEstimator velEst(3,10,2),jerkEst(3,16,3);
+    AWLinEstimator awVel(16,0.5);
+    JerkEstimator awJerk(16,0.1);
+
+    const double T=2.0;
+    double t=0.0,err_vel=0.0,err_aw_vel=0.0,err_jerk=0.0,err_aw_jerk=0.0,rms_jerk=0.0;
+    int n=0;
+    while (t<T)
+    {
+        t+=0.033+jitter(gen);
+        double x,v,j;
+        minjerk(t,T,x,v,j);
+
+        Vector p(3,0.0);
+        p[0]=0.3*x+noise(gen);
+        p[1]=0.1*x+noise(gen);
+        p[2]=noise(gen);
+
+        velEst.estimate(p,t);
+        jerkEst.estimate(p,t);
+        AWPolyElement el(p,t);
+        double aw_vel=norm(awVel.estimate(el));
+        double aw_jerk=norm(awJerk.estimate(el));
+
+        // skip the transient where windows are filling up
+        if (t>0.5)
+        {
+            double true_vel=sqrt(0.1)*v;
+            double true_jerk=sqrt(0.1)*fabs(j);
+            err_vel+=pow(norm(velEst.getVelocity())-true_vel,2);
+            err_aw_vel+=pow(aw_vel-true_vel,2);
+            err_jerk+=pow(norm(jerkEst.getJerk())-true_jerk,2);
+            err_aw_jerk+=pow(aw_jerk-true_jerk,2);
+            rms_jerk+=true_jerk*true_jerk;
+            n++;
+        }
+    }
+
+    err_vel=sqrt(err_vel/n);
+    err_aw_vel=sqrt(err_aw_vel/n);
+    err_jerk=sqrt(err_jerk/n);
+    err_aw_jerk=sqrt(err_aw_jerk/n);
+    rms_jerk=sqrt(rms_jerk/n);
+    cout<<"velocity rms error: "<<err_vel<<" (adaptive window "<<err_aw_vel<<")"<<endl;
+    cout<<"jerk rms error: "<<err_jerk<<" (adaptive window "<<err_aw_jerk<<")"<<endl;
+
+    if ((err_vel>0.02) || (err_vel>2.0*err_aw_vel))
+    {
+        cerr<<"velocity estimate too far from the expected one"<<endl;
+        return EXIT_FAILURE;
+    }
+    // the noise never exceeds the threshold of the adaptive window, which thus
+    // fits the same cubic; a null estimate would score an error of rms_jerk
+    if ((err_jerk>0.75*rms_jerk) || (err_jerk>1.1*err_aw_jerk))
+    {
+        cerr<<"jerk estimate too far from the expected one"<<endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int recorded(const string &file, const string &tag)
+{
+    ifstream fin(file);
+    if (!fin.is_open())
+    {
+        cerr<<"unable to open "<<file<<endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<double> times;
+    vector<Vector> points;
+    string line;
+    while (getline(fin,line))
+    {
+        Bottle b(line);
+        Bottle *sk=b.get(3).asList();
+        if (sk==nullptr)
+            continue;
+
+        Property prop(sk->toString().c_str());
+        unique_ptr<Skeleton> skeleton(skeleton_factory(prop));
+        if ((skeleton==nullptr) || ((*skeleton)[tag]==nullptr) ||
+            !(*skeleton)[tag]->isUpdated())
+            continue;
+
+        times.push_back(b.get(1).asDouble());
+        points.push_back((*skeleton)[tag]->getPoint());
+    }
+
+    if (times.size()<=18)
+    {
+        cerr<<"not enough samples of "<<tag<<" in "<<file<<endl;
+        return EXIT_FAILURE;
+    }
+
+    // both estimators are causal, hence they are compared
+    // against the central differences computed offline
+    DerivativeEstimator velEst(3,10,2);
+    AWLinEstimator awVel(16,0.5);
+    double err_vel=0.0,err_aw_vel=0.0;
+    int n=0;
+    for (size_t i=0; i+1<times.size(); i++)
+    {
+        velEst.estimate(points[i],times[i]);
+        AWPolyElement el(points[i],times[i]);
+        double aw_vel=norm(awVel.estimate(el));
+        if (i>16)
+        {
+            double ref_vel=norm((points[i+1]-points[i-1])/(times[i+1]-times[i-1]));
+            err_vel+=pow(norm(velEst.getVelocity())-ref_vel,2);
+            err_aw_vel+=pow(aw_vel-ref_vel,2);
+            n++;
+        }
+    }
+
+    err_vel=sqrt(err_vel/n);
+    err_aw_vel=sqrt(err_aw_vel/n);
+    cout<<n<<" samples of "<<tag<<": speed rms error = "<<err_vel
+        <<" (adaptive window "<<err_aw_vel<<")"<<endl;
+    if (err_vel>err_aw_vel)
+    {
+        cerr<<"speed estimate worse than the adaptive window one"<<endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    cout<<"### Minimum-jerk trajectory"<<endl;
+    if (synthetic()!=EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    // optionally, a recorded session and the keypoint to look at
+    if (argc>1)
+    {
+        cout<<"### Recorded session"<<endl;
+        return recorded(argv[1],(argc>2)?argv[2]:KeyPointTag::hand_left);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file test-lstm.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "classifier.h"
+#include "lstm.h"
+
+using namespace std;
+
+namespace
+{
+    const int nframes=30;
+    const int nwindows=64;
+
+    /****************************************************************/
+    int argmax(const float *s, const int n)
+    {
+        return (int)(max_element(s,s+n)-s);
+    }
+
+    /****************************************************************/
+    // max abs difference and number of windows classified differently
+    void compare(const vector<float> &a, const vector<float> &b, const int nclasses,
+                 double &maxerr, int &mismatches)
+    {
+        maxerr=0.0;
+        mismatches=0;
+        for (size_t i=0; i<a.size(); i++)
+            maxerr=std::max(maxerr,(double)fabs(a[i]-b[i]));
+        for (size_t w=0; w<a.size()/nclasses; w++)
+            if (argmax(&a[w*nclasses],nclasses)!=argmax(&b[w*nclasses],nclasses))
+                mismatches++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc<2)
+    {
+        cerr<<"usage: "<<argv[0]<<" <model path without extension>"<<endl;
+        return EXIT_FAILURE;
+    }
+    string model=argv[1];
+
+    Lstm native(false),quantized(true);
+    if (!native.load(model) || !quantized.load(model))
+    {
+        cerr<<native.getError()<<endl;
+        return EXIT_FAILURE;
+    }
+    int nfeatures=native.getNumFeatures();
+    int nclasses=native.getNumClasses();
+
+    // keypoints are normalized and scaled down by 10 before inference
+    mt19937 gen(0);
+    uniform_real_distribution<float> noise(-0.15f,0.15f);
+    vector<float> windows(nwindows*nframes*nfeatures);
+    for (int w=0; w<nwindows; w++)
+        for (int t=0; t<nframes; t++)
+            for (int f=0; f<nfeatures; f++)
+                windows[(w*nframes+t)*nfeatures+f]=
+                    0.1f*(float)sin(0.05*w*t+0.7*f)+noise(gen);
+
+    cout<<"### Batched vs one window at a time"<<endl;
+    vector<float> batch,single,scores;
+    if (!native.classify(windows.data(),nwindows,nframes,nfeatures,batch))
+    {
+        cerr<<native.getError()<<endl;
+        return EXIT_FAILURE;
+    }
+    for (int w=0; w<nwindows; w++)
+    {
+        native.classify(&windows[w*nframes*nfeatures],1,nframes,nfeatures,scores);
+        single.insert(single.end(),scores.begin(),scores.end());
+    }
+    double maxerr; int mismatches;
+    compare(batch,single,nclasses,maxerr,mismatches);
+    cout<<"max error = "<<maxerr<<endl;
+    if (maxerr>0.0)
+    {
+        cerr<<"batch does not match single windows"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### 8-bit vs float weights"<<endl;
+    quantized.classify(windows.data(),nwindows,nframes,nfeatures,scores);
+    compare(batch,scores,nclasses,maxerr,mismatches);
+    cout<<"max error = "<<maxerr<<"; mismatches = "<<mismatches<<"/"<<nwindows<<endl;
+    if ((maxerr>0.03) || (mismatches>0))
+    {
+        cerr<<"8-bit weights drift too much"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Native vs Tensorflow"<<endl;
+    unique_ptr<Classifier> tf(createTensorflowClassifier(1,1));
+    if (!tf)
+    {
+        cout<<"built without Tensorflow, skipping"<<endl;
+        return EXIT_SUCCESS;
+    }
+    if (!tf->load(model))
+    {
+        cerr<<tf->getError()<<endl;
+        return EXIT_FAILURE;
+    }
+
+    // the graph may not accept batches, hence windows go one by one
+    vector<float> reference;
+    for (int w=0; w<nwindows; w++)
+    {
+        if (!tf->classify(&windows[w*nframes*nfeatures],1,nframes,nfeatures,scores))
+        {
+            cerr<<tf->getError()<<endl;
+            return EXIT_FAILURE;
+        }
+        reference.insert(reference.end(),scores.begin(),scores.end());
+    }
+    compare(reference,single,nclasses,maxerr,mismatches);
+    cout<<"max error = "<<maxerr<<"; mismatches = "<<mismatches<<"/"<<nwindows<<endl;
+    if ((maxerr>1e-4) || (mismatches>0))
+    {
+        cerr<<"native inference does not match Tensorflow"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file test-modelcache.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "classifier.h"
+#include "modelcache.h"
+
+using namespace std;
+
+namespace
+{
+    // a network of given size, which scores one for every window
+    class Dummy : public Classifier
+    {
+        size_t bytes;
+    public:
+        Dummy(const size_t bytes) : bytes(bytes) { }
+        bool load(const string &) override { return true; }
+        bool classify(const float *, const int n, const int, const int,
+                      vector<float> &scores) override { scores.assign(n,1.0f); return true; }
+        string getError() const override { return ""; }
+        size_t getFootprint() const override { return bytes; }
+    };
+}
+
+int main()
+{
+    int nloads=0;
+    ModelCache cache;
+    cache.configure([&nloads](const string &part) -> Classifier* {
+                        nloads++;
+                        return (part=="missing"?nullptr:new Dummy(100));
+                    },250);
+
+    cout<<"### Loaded once"<<endl;
+    shared_ptr<Classifier> left=cache.get("left");
+    if (!left || (cache.get("left")!=left) || (nloads!=1))
+    {
+        cerr<<"the same part is loaded twice"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Least recently used evicted"<<endl;
+    cache.get("right");
+    cache.get("left");
+    cache.get("both");
+    cout<<"models = "<<cache.size()<<"; bytes = "<<cache.getFootprint()<<endl;
+    if (cache.contains("right") || !cache.contains("left") || !cache.contains("both") ||
+        (cache.getFootprint()!=200))
+    {
+        cerr<<"wrong model evicted"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Evicted model in use still valid"<<endl;
+    shared_ptr<Classifier> both=cache.get("both");
+    cache.get("left");
+    cache.get("right");
+    vector<float> window(10,0.0f),scores;
+    if (cache.contains("both") || !both->classify(window.data(),2,5,1,scores) ||
+        (scores.size()!=2) || (both->getFootprint()!=100))
+    {
+        cerr<<"model in use got lost"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Failures not cached"<<endl;
+    nloads=0;
+    if (cache.get("missing") || cache.get("missing") || (nloads!=2) || (cache.size()!=2))
+    {
+        cerr<<"failed load gets cached"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Requested model kept over budget"<<endl;
+    cache.configure([](const string &) -> Classifier* { return new Dummy(1000); },250);
+    if (!cache.get("left") || !cache.contains("left"))
+    {
+        cerr<<"requested model evicted"<<endl;
+        return EXIT_FAILURE;
+    }
+    cache.get("right");
+    if (cache.contains("left") || (cache.size()!=1))
+    {
+        cerr<<"budget exceeded"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
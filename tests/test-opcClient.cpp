@@ -0,0 +1,175 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file test-opcClient.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/math/Math.h>
+#include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/opcClient.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace assistive_rehab;
+
+// messages are fed as if they were received from the broadcast
+class Replica : public OpcClient
+{
+public:
+    void feed(const Bottle &msg) { store(msg); }
+};
+
+bool compare(const Skeleton &s1, const Skeleton &s2)
+{
+    if (s1.getTag()!=s2.getTag())
+        return false;
+    for (unsigned int i=0; i<s1.getNumKeyPoints(); i++)
+    {
+        if ((s1[i]->isUpdated()!=s2[i]->isUpdated()) ||
+            (s1[i]->isUpdated() && (norm(s1[i]->getPoint()-s2[i]->getPoint())>1e-6)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void addItem(Bottle &msg, const int id, Skeleton &skeleton)
+{
+    Bottle &item=msg.addList();
+    item.fromString(skeleton.toProperty().toString());
+    Bottle &field=item.addList();
+    field.addString("id");
+    field.addInt(id);
+}
+
+int main()
+{
+    SkeletonStd s1,s2;
+    s1.setTag("one");
+    s2.setTag("two");
+    vector<Vector> ordered;
+    for (unsigned int i=0; i<s1.getNumKeyPoints(); i++)
+        ordered.push_back(Vector(3,0.1*i));
+    s1.update(ordered);
+    for (auto &p:ordered)
+        p[2]+=1.0;
+    s2.update(ordered);
+
+    Replica opc;
+    vector<string> changed;
+    opc.addCallback([&changed](const vector<string> &tags) {
+        changed.insert(changed.end(),tags.begin(),tags.end());
+    });
+
+    cout<<"### Receiving two skeletons"<<endl;
+    Bottle msg;
+    msg.addString("sync");
+    addItem(msg,1,s1);
+    addItem(msg,2,s2);
+    opc.feed(msg);
+
+    SkeletonStd r1,r2;
+    if (!opc.getSkeleton("one",r1) || !opc.getSkeleton("two",r2) ||
+        !compare(s1,r1) || !compare(s2,r2))
+    {
+        cerr<<"wrong skeletons"<<endl;
+        return EXIT_FAILURE;
+    }
+    if (changed.size()!=2)
+    {
+        cerr<<"wrong notification"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Only modified skeletons notified"<<endl;
+    changed.clear();
+    opc.feed(msg);
+    if (!changed.empty())
+    {
+        cerr<<"unchanged skeletons notified"<<endl;
+        return EXIT_FAILURE;
+    }
+    for (auto &p:ordered)
+        p[0]+=0.5;
+    s2.update(ordered);
+    msg.clear();
+    msg.addString("sync");
+    addItem(msg,1,s1);
+    addItem(msg,2,s2);
+    opc.feed(msg);
+    if ((changed.size()!=1) || (changed[0]!="two") ||
+        !opc.getSkeleton("two",r2) || !compare(s2,r2))
+    {
+        cerr<<"wrong notification upon modification"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Same as going through Property"<<endl;
+    Property prop;
+    SkeletonStd r;
+    if (!opc.get("one",prop) || (prop.find("id").asInt()!=1))
+    {
+        cerr<<"wrong property"<<endl;
+        return EXIT_FAILURE;
+    }
+    unique_ptr<Skeleton> factory(skeleton_factory(prop));
+    r.update(factory->toProperty());
+    if (!compare(r,r1))
+    {
+        cerr<<"property and item differ"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Queries"<<endl;
+    vector<string> tags=opc.select("id",Value(2));
+    if ((tags.size()!=1) || (tags[0]!="two") || (opc.getTags("skeleton").size()!=2) ||
+        !opc.getTags("color").empty())
+    {
+        cerr<<"wrong queries"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Removing one skeleton"<<endl;
+    changed.clear();
+    msg.clear();
+    msg.addString("async");
+    addItem(msg,2,s2);
+    opc.feed(msg);
+    if (opc.has("one") || !opc.has("two") ||
+        (find(changed.begin(),changed.end(),"one")==changed.end()))
+    {
+        cerr<<"removed skeleton still there"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    // whatever is not an item is skipped
+    msg.clear();
+    msg.addString("async");
+    msg.addString("empty");
+    opc.feed(msg);
+    if (opc.has("two") || opc.getSkeleton("two",r))
+    {
+        cerr<<"database not emptied"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file test-profiler.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "AssistiveRehab/profiler.h"
+
+using namespace std;
+using namespace assistive_rehab;
+
+int main()
+{
+    Profiler profiler({"fast","slow"});
+
+    cout<<"### Recording synthetic durations from two threads"<<endl;
+    auto worker=[&profiler]()
+    {
+        for (uint64_t i=1; i<=1000; i++)
+        {
+            profiler.record(0,1000*i);
+            profiler.record(1,1000000*i);
+        }
+    };
+    thread t1(worker),t2(worker);
+    t1.join(); t2.join();
+
+    {
+        ScopedTimer timer(profiler,1);
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+
+    for (auto &s:profiler.getStats())
+    {
+        cout<<s.name<<": count="<<s.count<<" mean="<<s.mean
+            <<" p50="<<s.p50<<" p95="<<s.p95<<" p99="<<s.p99
+            <<" max="<<s.max<<endl;
+    }
+
+    StageStats fast=profiler.getStats(0);
+    StageStats slow=profiler.getStats(1);
+    if ((fast.count!=2000) || (slow.count!=2001))
+    {
+        cerr<<"wrong number of samples"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    // percentiles are quantized by the histogram resolution (~19%)
+    const double tol=0.2;
+    if ((fabs(fast.p50-500e-6)>tol*500e-6) || (fabs(fast.p99-990e-6)>tol*990e-6) ||
+        (fabs(fast.max-1e-3)>1e-12))
+    {
+        cerr<<"wrong percentiles"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Resetting"<<endl;
+    profiler.reset();
+    if (profiler.getStats(0).count!=0)
+    {
+        cerr<<"reset failed"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
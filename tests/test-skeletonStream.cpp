@@ -0,0 +1,188 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2018 Fondazione Istituto Italiano di Tecnologia (IIT)        *
+ * All Rights Reserved.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+/**
+ * @file test-skeletonStream.cpp
+ * @authors: Ugo Pattacini <ugo.pattacini@iit.it>
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/math/Math.h>
+#include "AssistiveRehab/skeleton.h"
+#include "AssistiveRehab/skeletonStream.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace assistive_rehab;
+
+bool compare(const Skeleton &s1, const Skeleton &s2)
+{
+    for (unsigned int i=0; i<s1.getNumKeyPoints(); i++)
+    {
+        if ((s1[i]->isUpdated()!=s2[i]->isUpdated()) ||
+            (s1[i]->isUpdated() && (norm(s1[i]->getPoint()-s2[i]->getPoint())>1e-6)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    SkeletonStd sender;
+    sender.setTag("test");
+
+    vector<Vector> ordered;
+    for (unsigned int i=0; i<sender.getNumKeyPoints(); i++)
+    {
+        Vector p(3,0.1*i);
+        ordered.push_back(p);
+    }
+    sender.update(ordered);
+
+    SkeletonStreamEncoder encoder(10);
+    Property extra;
+    extra.put("opacity",0.5);
+
+    cout<<"### Encoding the keyframe"<<endl;
+    Bottle msg;
+    if (!encoder.encode(sender,msg,extra))
+    {
+        cerr<<"keyframe expected"<<endl;
+        return EXIT_FAILURE;
+    }
+    cout<<"keyframe size = "<<msg.toString().size()<<" chars"<<endl;
+
+    Property prop(msg.get(0).asList()->toString().c_str());
+    unique_ptr<Skeleton> receiver(skeleton_factory(prop));
+    if ((receiver==nullptr) || !compare(sender,*receiver))
+    {
+        cerr<<"wrong keyframe"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Moving one keypoint"<<endl;
+    ordered[3][0]+=0.05;
+    sender.update(ordered);
+
+    msg.clear();
+    if (encoder.encode(sender,msg,extra))
+    {
+        cerr<<"delta expected"<<endl;
+        return EXIT_FAILURE;
+    }
+    cout<<"delta = "<<msg.toString()<<endl;
+
+    Bottle &item=*msg.get(0).asList();
+    string tag;
+    if (!SkeletonStreamDecoder::isDelta(item,tag) || (tag!=sender.getTag()) ||
+        (item.find("keys").asBlobLength()!=22) || (item.find("opacity").asDouble()!=0.5))
+    {
+        cerr<<"wrong delta"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!SkeletonStreamDecoder::decode(item,*receiver) || !compare(sender,*receiver))
+    {
+        cerr<<"wrong decoding"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Waiting for the next keyframe"<<endl;
+    int n=0;
+    do
+    {
+        msg.clear();
+        n++;
+    } while (!encoder.encode(sender,msg));
+    if (n!=9)
+    {
+        cerr<<"wrong keyframe period"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    cout<<"### Skipping deltas after a lost one"<<endl;
+    SkeletonStreamDecoder decoder;
+    if (!decoder.accept(*msg.get(0).asList()))
+    {
+        cerr<<"keyframe refused"<<endl;
+        return EXIT_FAILURE;
+    }
+    vector<bool> accepted;
+    for (int i=0; i<3; i++)
+    {
+        msg.clear();
+        encoder.encode(sender,msg);
+        if (i!=1)
+            accepted.push_back(decoder.accept(*msg.get(0).asList()));
+    }
+    if (!accepted[0] || accepted[1])
+    {
+        cerr<<"wrong sequence check"<<endl;
+        return EXIT_FAILURE;
+    }
+    do
+    {
+        msg.clear();
+        bool keyframe=encoder.encode(sender,msg);
+        if (decoder.accept(*msg.get(0).asList())!=keyframe)
+        {
+            cerr<<"delta accepted before the next keyframe"<<endl;
+            return EXIT_FAILURE;
+        }
+        if (keyframe)
+            break;
+    } while (true);
+
+    cout<<"### Encoding with a transformation"<<endl;
+    Matrix T=eye(4,4);
+    T(0,3)=1.0; T(1,0)=0.0; T(1,1)=0.0; T(1,2)=-1.0; T(2,1)=1.0; T(2,2)=0.0;
+    SkeletonStreamEncoder transformer(10);
+    transformer.setTransformation(T);
+    msg.clear();
+    transformer.encode(sender,msg);
+
+    // what the receiver is expected to get
+    SkeletonStd reference;
+    reference.update(sender.toProperty());
+    reference.setTransformation(T);
+    reference.update();
+    Property tprop(msg.get(0).asList()->toString().c_str());
+    unique_ptr<Skeleton> treceiver(skeleton_factory(tprop));
+    if ((treceiver==nullptr) || !compare(reference,*treceiver))
+    {
+        cerr<<"wrong transformed keyframe"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    ordered[5][1]+=0.05;
+    sender.update(ordered);
+    reference.update(sender.toProperty());
+    reference.setTransformation(T);
+    reference.update();
+    msg.clear();
+    transformer.encode(sender,msg);
+    if (!SkeletonStreamDecoder::decode(*msg.get(0).asList(),*treceiver) ||
+        !compare(reference,*treceiver))
+    {
+        cerr<<"wrong transformed delta"<<endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}